@@ -4,62 +4,117 @@ and then act on those values. You have the size of the array, the number of
 rotations,
 and then the direction that those rotations are supposed to take place towards
 (either L or R)*/
-#include <iostream>
 #include <vector>
-#include <sstream>
 #include <string>
+#include <algorithm>
+#include <cstddef>
+#include "fastio.h"
 using namespace std;
-// Function to rotate the array to the right
-void rotateRight(vector<int>& arr, int rotations) {
-int size = arr.size();
-if (size == 0) return; // Handle the case when the array is empty
-rotations = rotations % size; // Normalize rotations
-if (rotations > 0) {
-vector<int> temp(arr.end() - rotations, arr.end()); // Extract the last
-'rotations' elements
-arr.erase(arr.end() - rotations, arr.end()); // Remove the last 'rotations'
-elements
-arr.insert(arr.begin(), temp.begin(), temp.end()); // Insert them at the
-beginning
-}
-}
-// Function to rotate the array to the left
-void rotateLeft(vector<int>& arr, int rotations) {
-int size = arr.size();
-if (size == 0) return; // Handle the case when the array is empty
-rotations = rotations % size; // Normalize rotations
-if (rotations > 0) {
-vector<int> temp(arr.begin(), arr.begin() + rotations); // Extract the
-first 'rotations' elements
-arr.erase(arr.begin(), arr.begin() + rotations); // Remove the first
-'rotations' elements
-arr.insert(arr.end(), temp.begin(), temp.end()); // Insert them at the end
-}
-}
-// Function to print the elements of the vector
-void printVector(const vector<int>& vec) {
-for (int num : vec) {
-cout << num << " ";
-}
-cout << endl;
+
+// Buffered stdin/stdout shared by main and the print helpers
+FastInput input;
+FastOutput output;
+
+// A rotation of an array that is never carried out. The view only keeps the
+// logical start offset, so any run of L/R rotations composes in O(1) and the
+// elements are only walked when iterated, printed or materialized.
+template <typename T>
+class RotatedView {
+public:
+    class const_iterator {
+    public:
+        const_iterator(const T* base, size_t n, size_t pos) : base(base), n(n), pos(pos) {}
+        const T& operator*() const { return base[pos]; }
+        const_iterator& operator++() {
+            if (++pos == n) pos = 0;
+            ++walked;
+            return *this;
+        }
+        bool operator!=(const const_iterator& other) const { return walked != other.walked; }
+        void setEnd(size_t count) { walked = count; }
+    private:
+        const T* base;
+        size_t n;
+        size_t pos;
+        size_t walked = 0;  // Elements already visited, wrapping makes pos ambiguous
+    };
+
+    explicit RotatedView(vector<T>& data) : data(data), start(0) {}
+
+    size_t size() const { return data.size(); }
+    size_t offset() const { return start; }
+
+    void rotateLeft(size_t rotations) {
+        if (data.empty()) return;
+        start = (start + rotations % data.size()) % data.size();
+    }
+
+    void rotateRight(size_t rotations) {
+        if (data.empty()) return;
+        start = (start + data.size() - rotations % data.size()) % data.size();
+    }
+
+    const T& operator[](size_t i) const {
+        size_t j = start + i;
+        if (j >= data.size()) j -= data.size();
+        return data[j];
+    }
+
+    const_iterator begin() const { return const_iterator(data.data(), data.size(), start); }
+    const_iterator end() const {
+        const_iterator it(data.data(), data.size(), start);
+        it.setEnd(data.size());
+        return it;
+    }
+
+    // Visits the elements in rotated order as two contiguous runs
+    template <typename F>
+    void forEach(F visit) const {
+        for (size_t i = start; i < data.size(); ++i) visit(data[i]);
+        for (size_t i = 0; i < start; ++i) visit(data[i]);
+    }
+
+    // Applies the pending rotation to the underlying array and resets the offset. std::rotate
+    // works in place, so this never allocates either.
+    void materialize() {
+        rotate(data.begin(), data.begin() + start, data.end());
+        start = 0;
+    }
+
+private:
+    vector<T>& data;
+    size_t start;  // Index of the underlying element that is logically first
+};
+
+// Prints a rotated view without materializing the rotation
+void printVector(const RotatedView<int>& view) {
+    view.forEach([](int num) {
+        output.writeInt(num);
+        output.writeChar(' ');
+    });
+    output.writeChar('\n');
 }
+
 int main() {
-int num, rotations;
-char direction;
-// Process input until the end of the file so that regardless it will run
-while (cin >> num >> rotations >> direction) {
-vector<int> arr(num);
-for (int i = 0; i < num; ++i) {
-cin >> arr[i];
-}
-// Call rotation functions based on direction
-if (direction == 'R') {
-rotateRight(arr, rotations);
-} else if (direction == 'L') {
-rotateLeft(arr, rotations);
-}
-// Print the rotated array
-printVector(arr);
+    int num, rotations;
+    char direction;
+    // Process input until the end of the file so that regardless it will run
+    while (input.readInt(num) && input.readInt(rotations) && input.readChar(direction)) {
+        vector<int> arr(num);
+        for (int i = 0; i < num; ++i) {
+            input.readInt(arr[i]);
+        }
+        // Only the start offset moves, the array is read once when printed
+        RotatedView<int> view(arr);
+        if (rotations > 0) {
+            if (direction == 'R') {
+                view.rotateRight(rotations);
+            } else if (direction == 'L') {
+                view.rotateLeft(rotations);
+            }
+        }
+        // Print the rotated array
+        printVector(view);
+    }
+    return 0;
 }
-return 0;
-}
\ No newline at end of file
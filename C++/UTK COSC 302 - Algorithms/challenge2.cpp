@@ -2,22 +2,414 @@
 //
 //Description: This program finds the smallest difference between two elements in the array provided by the input file,
 //if there is more than one pair both are printed.
+//Running it with --radix sorts with an LSD radix sort and finds the pairs in two streaming passes instead,
+//and --threads N runs that same pipeline on N threads (0 picks one per core, build with -pthread).
+//Each dataset can also be asked for its K closest pairs (--top K) or every pair at most D apart (--within D),
+//the flags can be repeated and every query prints its own line against the same sorted array.
 
-#include <iostream>
 #include <vector>
 #include <algorithm>
 #include <cmath> // for abs()
+#include <climits>
+#include <cstdint>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <charconv>
+#include <queue>
+#include <string>
+#include <thread>
+#include "fastio.h"
+#include "threads.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-int main() {
+// Sorts the numbers with an LSD radix sort, one byte per pass. Flipping the sign bit makes
+// the two's complement keys order like unsigned ones, and passes where every key shares the
+// same byte are skipped. scratch is reused between calls so it only grows.
+void radixSort(std::vector<int>& numbers, std::vector<int>& scratch) {
+    const size_t n = numbers.size();
+    if (n < 2) return;
+    scratch.resize(n);
+
+    // Count all four byte histograms in a single pass
+    static size_t counts[4][256];
+    std::memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t key = static_cast<uint32_t>(numbers[i]) ^ 0x80000000u;
+        counts[0][key & 0xFF]++;
+        counts[1][(key >> 8) & 0xFF]++;
+        counts[2][(key >> 16) & 0xFF]++;
+        counts[3][key >> 24]++;
+    }
+
+    int* src = numbers.data();
+    int* dst = scratch.data();
+    for (int pass = 0; pass < 4; ++pass) {
+        const int shift = pass * 8;
+        size_t* count = counts[pass];
+        uint32_t first_key = static_cast<uint32_t>(src[0]) ^ 0x80000000u;
+        if (count[(first_key >> shift) & 0xFF] == n) continue; // Nothing to reorder on this byte
+
+        // Turn the histogram into starting offsets, then scatter
+        size_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t key = static_cast<uint32_t>(src[i]) ^ 0x80000000u;
+            dst[count[(key >> shift) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    // An odd number of passes leaves the result in the scratch buffer
+    if (src != numbers.data()) numbers.swap(scratch);
+}
+
+// Smallest gap between neighbours of a sorted array. The gaps are taken as unsigned 32-bit
+// values, which is exact for any pair of ints, and scanned four at a time with SSE2.
+uint32_t minAdjacentDiff(const int* sorted, size_t n) {
+    uint32_t best = UINT32_MAX;
+    size_t i = 1;
+#if defined(__SSE2__)
+    // SSE2 has no unsigned compare, so both sides are biased into signed range first
+    const __m128i bias = _mm_set1_epi32(INT_MIN);
+    __m128i best_lanes = _mm_set1_epi32(INT_MAX); // UINT32_MAX after biasing
+    for (; i + 4 <= n; i += 4) {
+        __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sorted + i));
+        __m128i prev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sorted + i - 1));
+        __m128i diff = _mm_xor_si128(_mm_sub_epi32(cur, prev), bias);
+        __m128i smaller = _mm_cmplt_epi32(diff, best_lanes);
+        best_lanes = _mm_or_si128(_mm_and_si128(smaller, diff), _mm_andnot_si128(smaller, best_lanes));
+    }
+    alignas(16) int32_t lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), best_lanes);
+    for (int lane = 0; lane < 4; ++lane) {
+        best = std::min(best, static_cast<uint32_t>(lanes[lane] ^ INT_MIN));
+    }
+#endif
+    for (; i < n; ++i) {
+        best = std::min(best, static_cast<uint32_t>(sorted[i]) - static_cast<uint32_t>(sorted[i - 1]));
+    }
+    return best;
+}
+
+// Second pass: writes every neighbouring pair whose gap equals min_diff, space separated,
+// so nothing has to be collected while the minimum is still shrinking
+void writeMinDiffPairs(const int* sorted, size_t n, uint32_t min_diff, FastOutput& output) {
+    bool first = true;
+    for (size_t i = 1; i < n; ++i) {
+        if (static_cast<uint32_t>(sorted[i]) - static_cast<uint32_t>(sorted[i - 1]) == min_diff) {
+            if (!first) output.writeChar(' ');
+            first = false;
+            output.writeInt(sorted[i - 1]);
+            output.writeChar(' ');
+            output.writeInt(sorted[i]);
+        }
+    }
+    output.writeChar('\n');
+}
+
+// Parallel version of radixSort. Every pass each thread histograms its own slice, the
+// per-thread counts are turned into offsets bucket by bucket, and the threads then scatter
+// their slices independently. Keeping slices in thread order keeps every pass stable.
+void parallelRadixSort(std::vector<int>& numbers, std::vector<int>& scratch, unsigned threads) {
+    const size_t n = numbers.size();
+    if (threads <= 1 || n < threads * 1024) {
+        radixSort(numbers, scratch);
+        return;
+    }
+    scratch.resize(n);
+
+    std::vector<size_t> counts(threads * 256);
+    int* src = numbers.data();
+    int* dst = scratch.data();
+    for (int pass = 0; pass < 4; ++pass) {
+        const int shift = pass * 8;
+        std::fill(counts.begin(), counts.end(), 0);
+        parallelChunks(threads, 0, n, [&](unsigned t, size_t lo, size_t hi) {
+            size_t* count = &counts[t * 256];
+            for (size_t i = lo; i < hi; ++i) {
+                count[((static_cast<uint32_t>(src[i]) ^ 0x80000000u) >> shift) & 0xFF]++;
+            }
+        });
+
+        uint32_t first_bucket = ((static_cast<uint32_t>(src[0]) ^ 0x80000000u) >> shift) & 0xFF;
+        size_t first_total = 0;
+        for (unsigned t = 0; t < threads; ++t) first_total += counts[t * 256 + first_bucket];
+        if (first_total == n) continue; // Nothing to reorder on this byte
+
+        // Bucket major, thread minor, so thread t's keys land after thread t-1's in each bucket
+        size_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            for (unsigned t = 0; t < threads; ++t) {
+                size_t c = counts[t * 256 + b];
+                counts[t * 256 + b] = offset;
+                offset += c;
+            }
+        }
+        parallelChunks(threads, 0, n, [&](unsigned t, size_t lo, size_t hi) {
+            size_t* next = &counts[t * 256];
+            for (size_t i = lo; i < hi; ++i) {
+                dst[next[((static_cast<uint32_t>(src[i]) ^ 0x80000000u) >> shift) & 0xFF]++] = src[i];
+            }
+        });
+        std::swap(src, dst);
+    }
+
+    if (src != numbers.data()) numbers.swap(scratch);
+}
+
+// Parallel min gap. Each chunk covers the gaps ending at indices [lo, hi), so the gap that
+// straddles two chunks belongs to the later one and reads one element back into the earlier.
+uint32_t parallelMinAdjacentDiff(const int* sorted, size_t n, unsigned threads) {
+    if (threads <= 1 || n < threads * 1024) return minAdjacentDiff(sorted, n);
+    std::vector<uint32_t> chunk_min(threads, UINT32_MAX);
+    parallelChunks(threads, 1, n, [&](unsigned t, size_t lo, size_t hi) {
+        if (hi > lo) chunk_min[t] = minAdjacentDiff(sorted + lo - 1, hi - lo + 1);
+    });
+    return *std::min_element(chunk_min.begin(), chunk_min.end());
+}
+
+// Appends the decimal form of value to text
+void appendInt(std::string& text, int value) {
+    char digits[16];
+    char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    text.append(digits, end);
+}
+
+// Parallel second pass. Each chunk formats its own pairs at the minimum gap, and the chunks
+// are then written in order with the same separators as writeMinDiffPairs.
+void parallelWriteMinDiffPairs(const int* sorted, size_t n, uint32_t min_diff, unsigned threads, FastOutput& output) {
+    if (threads <= 1 || n < threads * 1024) {
+        writeMinDiffPairs(sorted, n, min_diff, output);
+        return;
+    }
+    std::vector<std::string> chunk_text(threads);
+    parallelChunks(threads, 1, n, [&](unsigned t, size_t lo, size_t hi) {
+        std::string& text = chunk_text[t];
+        for (size_t i = lo; i < hi; ++i) {
+            if (static_cast<uint32_t>(sorted[i]) - static_cast<uint32_t>(sorted[i - 1]) == min_diff) {
+                text.push_back(' ');
+                appendInt(text, sorted[i - 1]);
+                text.push_back(' ');
+                appendInt(text, sorted[i]);
+            }
+        }
+    });
+
+    // Every pair was written with a leading space, the very first one must not be
+    bool first = true;
+    for (const std::string& text : chunk_text) {
+        if (text.empty()) continue;
+        if (first) {
+            output.writeString(text.data() + 1, text.size() - 1);
+            first = false;
+        } else {
+            output.writeString(text);
+        }
+    }
+    output.writeChar('\n');
+}
+
+// Writes pairs in the usual output format, all on one line separated by spaces
+void writePairs(const std::vector<std::pair<int, int>>& pairs, FastOutput& output) {
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (i > 0) output.writeChar(' ');
+        output.writeInt(pairs[i].first);
+        output.writeChar(' ');
+        output.writeInt(pairs[i].second);
+    }
+    output.writeChar('\n');
+}
+
+// One dataset sorted once, so any number of closest-pair queries can run against it without
+// sorting again. Pairs are positions i < j of the sorted array and their distance is
+// sorted[j] - sorted[i]; ties are broken by position.
+class ClosestPairIndex {
+public:
+    ClosestPairIndex(std::vector<int> numbers, std::vector<int>& scratch, unsigned threads)
+        : sorted(std::move(numbers)), threads(threads) {
+        parallelRadixSort(sorted, scratch, threads);
+        min_diff = parallelMinAdjacentDiff(sorted.data(), sorted.size(), threads);
+    }
+
+    const std::vector<int>& values() const { return sorted; }
+
+    // Smallest distance in the dataset, UINT32_MAX when there are fewer than two values
+    uint32_t minDiff() const { return min_diff; }
+
+    // The original query: every neighbouring pair at the smallest distance
+    void writeMinDiffPairs(FastOutput& output) const {
+        parallelWriteMinDiffPairs(sorted.data(), sorted.size(), min_diff, threads, output);
+    }
+
+    // The k closest pairs, nearest first. A bounded max-heap keeps the k smallest neighbouring
+    // gaps as seeds, then a min-heap pops pairs in order and only ever extends the popped pair
+    // (i, j) to (i, j + 1). Any pair skipped that way is farther than k seeds already, so both
+    // heaps stay within O(k) entries.
+    std::vector<std::pair<int, int>> closestPairs(size_t k) const {
+        std::vector<std::pair<int, int>> result;
+        const size_t n = sorted.size();
+        if (k == 0 || n < 2) return result;
+
+        std::priority_queue<Candidate, std::vector<Candidate>, Nearer> seeds;
+        for (size_t i = 0; i + 1 < n; ++i) {
+            Candidate gap = candidate(i, i + 1);
+            if (seeds.size() < k) {
+                seeds.push(gap);
+            } else if (Nearer()(gap, seeds.top())) {
+                seeds.pop();
+                seeds.push(gap);
+            }
+        }
+
+        std::vector<Candidate> seed_list;
+        seed_list.reserve(seeds.size());
+        while (!seeds.empty()) {
+            seed_list.push_back(seeds.top());
+            seeds.pop();
+        }
+        std::priority_queue<Candidate, std::vector<Candidate>, Farther> frontier(Farther(), std::move(seed_list));
+        while (result.size() < k && !frontier.empty()) {
+            Candidate best = frontier.top();
+            frontier.pop();
+            result.push_back({sorted[best.i], sorted[best.j]});
+            if (best.j + 1 < n) frontier.push(candidate(best.i, best.j + 1));
+        }
+        return result;
+    }
+
+    // Calls visit(a, b) for every pair at most max_diff apart, in sorted order of a then b.
+    // Nothing is stored, the cost is the number of pairs reported plus one step per value.
+    template <typename Visit>
+    void forEachPairWithin(uint32_t max_diff, Visit visit) const {
+        const size_t n = sorted.size();
+        for (size_t i = 0; i + 1 < n; ++i) {
+            for (size_t j = i + 1; j < n && distance(i, j) <= max_diff; ++j) {
+                visit(sorted[i], sorted[j]);
+            }
+        }
+    }
+
+    // Writes every pair at most max_diff apart on one line
+    void writePairsWithin(uint32_t max_diff, FastOutput& output) const {
+        bool first = true;
+        forEachPairWithin(max_diff, [&](int a, int b) {
+            if (!first) output.writeChar(' ');
+            first = false;
+            output.writeInt(a);
+            output.writeChar(' ');
+            output.writeInt(b);
+        });
+        output.writeChar('\n');
+    }
+
+private:
+    struct Candidate {
+        uint32_t diff;
+        size_t i;
+        size_t j;
+    };
+
+    // Orders candidates by distance, then by position
+    struct Nearer {
+        bool operator()(const Candidate& a, const Candidate& b) const {
+            if (a.diff != b.diff) return a.diff < b.diff;
+            if (a.i != b.i) return a.i < b.i;
+            return a.j < b.j;
+        }
+    };
+
+    struct Farther {
+        bool operator()(const Candidate& a, const Candidate& b) const { return Nearer()(b, a); }
+    };
+
+    uint32_t distance(size_t i, size_t j) const {
+        return static_cast<uint32_t>(sorted[j]) - static_cast<uint32_t>(sorted[i]);
+    }
+
+    Candidate candidate(size_t i, size_t j) const { return {distance(i, j), i, j}; }
+
+    std::vector<int> sorted;
+    unsigned threads;
+    uint32_t min_diff;
+};
+
+// A query requested on the command line
+struct PairQuery {
+    enum Kind { TopK, Within } kind;
+    unsigned long value;
+};
+
+// Parses the value of --top or --within into value. Negative or non-numeric values print a
+// message on stderr and return false, strtoul alone would wrap "-1" to the largest count.
+bool parseQueryValue(const char* flag, const char* text, unsigned long& value) {
+    char* end = nullptr;
+    errno = 0;
+    long long parsed = std::strtoll(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < 0) {
+        std::fprintf(stderr, "%s needs a value of 0 or more, got '%s'\n", flag, text);
+        return false;
+    }
+    value = static_cast<unsigned long>(parsed);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    FastInput input;
+    FastOutput output;
     int n;
 
+    bool use_radix = false;
+    unsigned threads = 1;
+    std::vector<PairQuery> queries;
+    for (int a = 1; a < argc; ++a) {
+        if (std::strcmp(argv[a], "--radix") == 0) {
+            use_radix = true;
+        } else if (std::strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+            use_radix = true;
+            if (!parseThreadCount(argv[++a], threads)) return 1;
+        } else if (std::strcmp(argv[a], "--top") == 0 && a + 1 < argc) {
+            use_radix = true;
+            PairQuery query{PairQuery::TopK, 0};
+            if (!parseQueryValue("--top", argv[++a], query.value)) return 1;
+            queries.push_back(query);
+        } else if (std::strcmp(argv[a], "--within") == 0 && a + 1 < argc) {
+            use_radix = true;
+            PairQuery query{PairQuery::Within, 0};
+            if (!parseQueryValue("--within", argv[++a], query.value)) return 1;
+            queries.push_back(query);
+        }
+    }
+    std::vector<int> scratch; // Radix sort buffer, kept across test cases
+
     // Keep reading until end of input (EOF)
-    while (std::cin >> n) { // Read the number of elements
+    while (input.readInt(n)) { // Read the number of elements
         std::vector<int> numbers(n);
 
         // Read the elements into the vector
         for(int i = 0; i < n; ++i) {
-            std::cin >> numbers[i];
+            input.readInt(numbers[i]);
+        }
+
+        if (use_radix) {
+            // Sort once, then answer every query against the same index
+            ClosestPairIndex index(std::move(numbers), scratch, threads);
+            if (queries.empty()) index.writeMinDiffPairs(output);
+            for (const PairQuery& query : queries) {
+                if (query.kind == PairQuery::TopK) {
+                    writePairs(index.closestPairs(query.value), output);
+                } else {
+                    index.writePairsWithin(static_cast<uint32_t>(std::min<unsigned long>(query.value, UINT32_MAX)), output);
+                }
+            }
+            continue;
         }
 
         // Sort the vector
@@ -44,12 +436,14 @@ int main() {
         // Output all pairs with the smallest difference in array format
         for(size_t i = 0; i < min_diff_pairs.size(); ++i) {
             const auto& pair = min_diff_pairs[i];
-            std::cout << pair.first << " " << pair.second;
+            output.writeInt(pair.first);
+            output.writeChar(' ');
+            output.writeInt(pair.second);
             if (i < min_diff_pairs.size() - 1) {
-                std::cout << " ";
+                output.writeChar(' ');
             }
         }
-        std::cout << std::endl; // Print a new line after the output to ensure that extra space is gone
+        output.writeChar('\n'); // Print a new line after the output to ensure that extra space is gone
     }
 
     return 0;
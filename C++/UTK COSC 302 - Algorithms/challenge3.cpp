@@ -2,13 +2,34 @@
 //
 //This program takes an input from the 'input' file and checks to see if it were rearranged could it make the same statement. Not to be
 //confused with a palindrome, which is reverse order creates the same word.
+//Lines are checked by toggling one parity bit per letter, --reference switches back to the original counting map.
+//With --threads N the input is cut into large blocks of whole lines that N workers classify in parallel, and the
+//results are still written in input order (build with -pthread). --utf8 decodes the lines as UTF-8 and counts
+//letters from other scripts too, folding case for the ones that have it.
 
 
 
-#include <iostream>
 #include <string>
 #include <unordered_map>
 #include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include "fastio.h"
+#include "threads.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define PALINDROME_HAVE_AVX2 1
+#endif
 
 bool is_palindrome_permutation(const std::string& s) {
     std::unordered_map<char, int> freq_map;
@@ -33,16 +54,488 @@ bool is_palindrome_permutation(const std::string& s) {
     return odd_count <= 1;
 }
 
-int main() {
+// One bit per letter for each byte value, both cases sharing a bit and everything that is not
+// an ASCII letter mapping to 0. This is what std::isalpha/std::tolower give in the "C" locale.
+struct LetterBits {
+    uint32_t bit[256];
+    LetterBits() {
+        std::memset(bit, 0, sizeof(bit));
+        for (int c = 0; c < 26; ++c) {
+            bit['a' + c] = uint32_t(1) << c;
+            bit['A' + c] = uint32_t(1) << c;
+        }
+    }
+};
+static const LetterBits letter_bits;
+
+// Folds a run of bytes into the parity mask one table lookup at a time. Four independent
+// masks keep the XORs from waiting on each other.
+inline uint32_t letterParityScalar(const unsigned char* data, size_t size, uint32_t parity) {
+    uint32_t p1 = 0, p2 = 0, p3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        parity ^= letter_bits.bit[data[i]];
+        p1 ^= letter_bits.bit[data[i + 1]];
+        p2 ^= letter_bits.bit[data[i + 2]];
+        p3 ^= letter_bits.bit[data[i + 3]];
+    }
+    for (; i < size; ++i) {
+        parity ^= letter_bits.bit[data[i]];
+    }
+    return parity ^ p1 ^ p2 ^ p3;
+}
+
+#if defined(__SSE2__)
+// SSE2 has no per-lane variable shift, so it is only used to classify 16 bytes at a time:
+// blocks without a single letter (padding, digits, punctuation runs) are skipped and the rest
+// go through the table
+uint32_t letterParitySSE2(const unsigned char* data, size_t size) {
+    uint32_t parity = 0;
+    size_t i = 0;
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i before_a = _mm_set1_epi8('a' - 1);
+    const __m128i after_z = _mm_set1_epi8('z' + 1);
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i folded = _mm_or_si128(bytes, case_bit);
+        // Signed compares are fine, bytes with the top bit set are negative and never letters
+        __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(folded, before_a), _mm_cmplt_epi8(folded, after_z));
+        if (_mm_movemask_epi8(letters) != 0) {
+            parity = letterParityScalar(data + i, 16, parity);
+        }
+    }
+    return letterParityScalar(data + i, size - i, parity);
+}
+#endif
+
+#if defined(PALINDROME_HAVE_AVX2)
+// AVX2 handles 32 bytes per step: each byte becomes its letter index (or 0xFF when it is not
+// a letter), is widened to a 32-bit lane and turned into a one-hot bit with a variable shift.
+// Shifts of 32 or more give 0, so non-letters drop out for free. XOR-ing the one-hot lanes
+// keeps eight partial parities that are folded together at the end.
+__attribute__((target("avx2")))
+uint32_t letterParityAVX2(const unsigned char* data, size_t size) {
+    size_t i = 0;
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i letter_a = _mm256_set1_epi8('a');
+    const __m256i last_index = _mm256_set1_epi8(25);
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 32 <= size; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i index = _mm256_sub_epi8(_mm256_or_si256(bytes, case_bit), letter_a);
+        __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(index, last_index), index);
+        index = _mm256_or_si256(index, _mm256_andnot_si256(is_letter, _mm256_set1_epi8(-1)));
+
+        __m128i low = _mm256_castsi256_si128(index);
+        __m128i high = _mm256_extracti128_si256(index, 1);
+        acc = _mm256_xor_si256(acc, _mm256_sllv_epi32(one, _mm256_cvtepu8_epi32(low)));
+        acc = _mm256_xor_si256(acc, _mm256_sllv_epi32(one, _mm256_cvtepu8_epi32(_mm_srli_si128(low, 8))));
+        acc = _mm256_xor_si256(acc, _mm256_sllv_epi32(one, _mm256_cvtepu8_epi32(high)));
+        acc = _mm256_xor_si256(acc, _mm256_sllv_epi32(one, _mm256_cvtepu8_epi32(_mm_srli_si128(high, 8))));
+    }
+    __m128i folded = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    folded = _mm_xor_si128(folded, _mm_srli_si128(folded, 8));
+    folded = _mm_xor_si128(folded, _mm_srli_si128(folded, 4));
+    uint32_t parity = static_cast<uint32_t>(_mm_cvtsi128_si32(folded));
+    return letterParityScalar(data + i, size - i, parity);
+}
+#endif
+
+// Parity mask of the letters in a line: bit c is set when letter 'a' + c appears an odd number
+// of times. Picks the widest kernel the CPU supports, checked once.
+uint32_t letterParity(const char* text, size_t size) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text);
+#if defined(PALINDROME_HAVE_AVX2)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) return letterParityAVX2(data, size);
+#endif
+#if defined(__SSE2__)
+    return letterParitySSE2(data, size);
+#else
+    return letterParityScalar(data, size, 0);
+#endif
+}
+
+// Same answer as is_palindrome_permutation without counting anything: a line can be rearranged
+// into a palindrome when at most one letter has odd parity, i.e. the mask has at most one bit set.
+// No allocation and no locale lookups.
+bool is_palindrome_permutation_fast(const char* text, size_t size) {
+    uint32_t parity = letterParity(text, size);
+    return (parity & (parity - 1)) == 0;
+}
+
+// Decodes the UTF-8 sequence at data[0..size) into code_point and returns how many bytes it
+// used. Malformed, overlong, surrogate and out of range sequences use up a single byte and come
+// back as U+FFFD, which is not a letter. The sequence length comes from a table on the lead byte
+// and the checks are combined without branching, so mixed 2 and 3 byte text only pays for the
+// one switch.
+size_t decodeUtf8(const unsigned char* data, size_t size, uint32_t& code_point) {
+    static const unsigned char lengths[32] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+                                              0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 3, 3, 4, 0};
+    unsigned char lead = data[0];
+    size_t length = lengths[lead >> 3];
+    if (length > size) length = 0;
+
+    uint32_t cp;
+    bool valid;
+    switch (length) {
+        case 1:
+            code_point = lead;
+            return 1;
+        case 2:
+            cp = ((lead & 0x1Fu) << 6) | (data[1] & 0x3Fu);
+            valid = ((data[1] & 0xC0) == 0x80) & (cp >= 0x80);
+            break;
+        case 3:
+            cp = ((lead & 0x0Fu) << 12) | ((data[1] & 0x3Fu) << 6) | (data[2] & 0x3Fu);
+            valid = ((data[1] & 0xC0) == 0x80) & ((data[2] & 0xC0) == 0x80) & (cp >= 0x800) &
+                    ((cp < 0xD800) | (cp > 0xDFFF));
+            break;
+        case 4:
+            cp = ((lead & 0x07u) << 18) | ((data[1] & 0x3Fu) << 12) | ((data[2] & 0x3Fu) << 6) | (data[3] & 0x3Fu);
+            valid = ((data[1] & 0xC0) == 0x80) & ((data[2] & 0xC0) == 0x80) & ((data[3] & 0xC0) == 0x80) &
+                    (cp >= 0x10000) & (cp <= 0x10FFFF);
+            break;
+        default:
+            valid = false;
+            cp = 0;
+            break;
+    }
+    if (!valid) {
+        code_point = 0xFFFD;
+        return 1;
+    }
+    code_point = cp;
+    return length;
+}
+
+// Simple case folding for the letters this mode knows about, 0 for anything else. Case is
+// folded for ASCII, Latin-1, Latin Extended-A, Latin Extended Additional, Greek, Cyrillic,
+// Armenian and fullwidth Latin. Latin Extended-B, Hebrew, Arabic, kana, CJK ideographs and
+// Hangul syllables count as letters as they are.
+uint32_t foldLetter(uint32_t cp) {
+    if (cp < 0x80) {
+        if (cp >= 'A' && cp <= 'Z') return cp + 32;
+        return (cp >= 'a' && cp <= 'z') ? cp : 0;
+    }
+    if (cp < 0x100) {
+        if (cp == 0xAA || cp == 0xBA) return cp;
+        if (cp == 0xB5) return 0x3BC;                                  // Micro sign folds to mu
+        if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) return cp + 32;
+        if (cp >= 0xDF && cp != 0xF7) return cp;
+        return 0;
+    }
+    if (cp < 0x180) {
+        if (cp == 0x130 || cp == 0x131 || cp == 0x138 || cp == 0x149) return cp;
+        if (cp == 0x178) return 0xFF;
+        if (cp == 0x17F) return 's';
+        if ((cp >= 0x139 && cp <= 0x148) || cp >= 0x179) return (cp & 1) ? cp + 1 : cp;
+        return cp | 1;                                                 // Upper case on the even code point
+    }
+    if (cp < 0x250) return cp;
+    if (cp >= 0x370 && cp < 0x400) {
+        if (cp >= 0x391 && cp <= 0x3AB && cp != 0x3A2) return cp + 32;
+        if (cp == 0x386) return 0x3AC;
+        if (cp >= 0x388 && cp <= 0x38A) return cp + 37;
+        if (cp == 0x38C) return 0x3CC;
+        if (cp == 0x38E || cp == 0x38F) return cp + 63;
+        if (cp == 0x3C2) return 0x3C3;                                 // Final sigma
+        if (cp == 0x390 || (cp >= 0x3AC && cp <= 0x3CE)) return cp;
+        return 0;
+    }
+    if (cp >= 0x400 && cp < 0x530) {
+        if (cp <= 0x40F) return cp + 80;
+        if (cp <= 0x42F) return cp + 32;
+        if (cp <= 0x45F) return cp;
+        if (cp <= 0x481 || (cp >= 0x48A && cp <= 0x4BF) || cp >= 0x4D0) return cp | 1;
+        if (cp == 0x4C0) return 0x4CF;
+        if (cp >= 0x4C1 && cp <= 0x4CE) return (cp & 1) ? cp + 1 : cp;
+        return (cp == 0x4CF) ? cp : 0;
+    }
+    if (cp >= 0x531 && cp <= 0x556) return cp + 48;
+    if ((cp >= 0x561 && cp <= 0x587) || (cp >= 0x5D0 && cp <= 0x5EA) || (cp >= 0x620 && cp <= 0x64A)) return cp;
+    if (cp >= 0x1E00 && cp <= 0x1EFF) {
+        if (cp == 0x1E9E) return 0xDF;                                 // Capital sharp s
+        if (cp == 0x1E9B) return 0x1E61;                               // Long s with dot above
+        if (cp >= 0x1E96 && cp <= 0x1E9F) return cp;
+        return cp | 1;
+    }
+    if (cp == 0x212A) return 'k';                                      // Kelvin sign
+    if (cp == 0x212B) return 0xE5;                                     // Angstrom sign
+    if ((cp >= 0x3041 && cp <= 0x3096) || (cp >= 0x30A1 && cp <= 0x30FA)) return cp;
+    if ((cp >= 0x4E00 && cp <= 0x9FFF) || (cp >= 0xAC00 && cp <= 0xD7A3)) return cp;
+    if (cp >= 0xFF21 && cp <= 0xFF3A) return cp + 32;
+    if (cp >= 0xFF41 && cp <= 0xFF5A) return cp;
+    return 0;
+}
+
+// Odd/even parity per code point in an open addressing table with linear probing. Each slot is
+// the key with the parity in its low bit plus the number of the line that last wrote it, so
+// starting a new line just bumps that number (and clears the stamps once every 2^32 lines). The
+// table is reused from line to line and only grows (at half load) to twice the most distinct
+// non-ASCII letters any line has had, which bounds it by the line's alphabet rather than its length.
+class CodePointParity {
+public:
+    CodePointParity() : slots(64), line(1), used(0), odd(0) {}
+
+    void reset() {
+        if (++line == 0) {
+            // The stamp wrapped, so old slots (and never used ones, stamped 0) would read as live
+            for (Slot& slot : slots) slot.line = 0;
+            line = 1;
+        }
+        used = 0;
+        odd = 0;
+    }
+
+    void toggle(uint32_t code_point) {
+        if ((used + 1) * 2 > slots.size()) grow();
+        size_t mask = slots.size() - 1;
+        size_t index = hash(code_point) & mask;
+        while (slots[index].line == line) {
+            if ((slots[index].key >> 1) == code_point) {
+                slots[index].key ^= 1;
+                odd += (slots[index].key & 1) ? 1 : -1;
+                return;
+            }
+            index = (index + 1) & mask;
+        }
+        slots[index].key = (code_point << 1) | 1;
+        slots[index].line = line;
+        ++used;
+        ++odd;
+    }
+
+    // Number of letters seen an odd number of times since the last reset
+    size_t oddCount() const { return odd; }
+
+private:
+    struct Slot {
+        uint32_t key = 0;   // Code point << 1 | parity
+        uint32_t line = 0;  // Entry is only live when this matches the current line
+    };
+
+    static size_t hash(uint32_t code_point) { return (code_point * 0x9E3779B1u) >> 7; }
+
+    void grow() {
+        std::vector<Slot> old(slots.size() * 2);
+        old.swap(slots);
+        size_t mask = slots.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.line != line) continue;
+            size_t index = hash(slot.key >> 1) & mask;
+            while (slots[index].line == line) index = (index + 1) & mask;
+            slots[index] = slot;
+        }
+    }
+
+    std::vector<Slot> slots;
+    uint32_t line;
+    size_t used;
+    size_t odd;
+};
+
+// UTF-8 version of the check. ASCII letters keep using the 26-bit mask, other letters are
+// decoded, case folded and toggled in the per-thread parity table.
+bool is_palindrome_permutation_utf8(const char* text, size_t size) {
+    thread_local CodePointParity wide;
+    wide.reset();
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text);
+    uint32_t ascii = 0;
+    // Every byte is visited instead of jumping from sequence to sequence: decoding only ever
+    // yields something at bytes that are not continuation bytes, and stepping by one keeps the
+    // loop free of the load -> length -> index dependency that otherwise limits throughput
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char byte = data[i];
+        if (byte < 0x80) {
+            ascii ^= letter_bits.bit[byte];
+            continue;
+        }
+        if ((byte & 0xC0) == 0x80) continue;
+        uint32_t code_point;
+        decodeUtf8(data + i, size - i, code_point);
+        uint32_t folded = foldLetter(code_point);
+        if (folded == 0) continue;
+        if (folded < 0x80) {
+            ascii ^= letter_bits.bit[folded];  // Kelvin sign, long s
+        } else {
+            wide.toggle(folded);
+        }
+    }
+    size_t odd = wide.oddCount() + ((ascii == 0) ? 0 : ((ascii & (ascii - 1)) == 0 ? 1 : 2));
+    return odd <= 1;
+}
+
+// Which of the checks to run on each line
+enum class CheckMode { Fast, Reference, Utf8 };
+
+bool checkLine(CheckMode mode, const char* text, size_t size) {
+    switch (mode) {
+        case CheckMode::Reference:
+            return is_palindrome_permutation(std::string(text, size));
+        case CheckMode::Utf8:
+            return is_palindrome_permutation_utf8(text, size);
+        default:
+            return is_palindrome_permutation_fast(text, size);
+    }
+}
+
+// Writes the verdict for one line in the usual format
+void appendVerdict(std::string& out, const char* line, size_t size, bool palindrome) {
+    out.push_back('"');
+    out.append(line, size);
+    if (palindrome) {
+        out.append("\" is a palindrome permutation\n");
+    } else {
+        out.append("\" is not a palindrome permutation\n");
+    }
+}
+
+// Classifies every line of a block of whole lines and formats all of their output into out
+void classifyBlock(const std::string& block, std::string& out, CheckMode mode) {
+    out.clear();
+    out.reserve(block.size() + block.size() / 2);
+    size_t start = 0;
+    while (start < block.size()) {
+        const char* begin = block.data() + start;
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', block.size() - start));
+        size_t size = newline ? static_cast<size_t>(newline - begin) : block.size() - start;
+        bool palindrome = checkLine(mode, begin, size);
+        appendVerdict(out, begin, size, palindrome);
+        start += size + 1;
+    }
+}
+
+// Reader -> worker pool -> ordered writer. A reader thread cuts stdin into blocks of about
+// BLOCK_BYTES that end on a newline (the unfinished line is carried into the next block) and
+// numbers them. Workers classify whole blocks, and this thread writes each block's output with
+// one write once every earlier block is out. At most a few blocks per worker are in flight, so
+// memory stays bounded however large the input is.
+void runPipeline(FastInput& input, FastOutput& output, unsigned workers, CheckMode mode) {
+    const size_t BLOCK_BYTES = 4 << 20;
+    const size_t MAX_IN_FLIGHT = 2 * workers + 2;
+
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<std::pair<size_t, std::string>> pending;  // Read, waiting for a worker
+    std::map<size_t, std::string> finished;              // Classified, waiting for the writer
+    size_t blocks_read = 0;
+    size_t in_flight = 0;
+    bool reading_done = false;
+
+    std::thread reader([&]() {
+        std::string carry;
+        bool at_end = false;
+        while (!at_end) {
+            std::string block = std::move(carry);
+            carry.clear();
+            while (true) {
+                size_t old_size = block.size();
+                block.resize(old_size + BLOCK_BYTES);
+                size_t got = input.readRaw(&block[old_size], BLOCK_BYTES);
+                block.resize(old_size + got);
+                if (got == 0) {
+                    at_end = true;
+                    break;
+                }
+                if (block.size() < BLOCK_BYTES) continue;
+                size_t last_newline = block.rfind('\n');
+                if (last_newline == std::string::npos) continue; // One very long line, keep going
+                carry.assign(block, last_newline + 1, std::string::npos);
+                block.resize(last_newline + 1);
+                break;
+            }
+            if (block.empty()) break;
+
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() { return in_flight < MAX_IN_FLIGHT; });
+            pending.emplace_back(blocks_read++, std::move(block));
+            ++in_flight;
+            changed.notify_all();
+        }
+        std::lock_guard<std::mutex> guard(lock);
+        reading_done = true;
+        changed.notify_all();
+    });
+
+    std::vector<std::thread> pool;
+    for (unsigned w = 0; w < workers; ++w) {
+        pool.emplace_back([&]() {
+            std::string out;
+            while (true) {
+                std::pair<size_t, std::string> job;
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    changed.wait(guard, [&]() { return !pending.empty() || reading_done; });
+                    if (pending.empty()) return;
+                    job = std::move(pending.front());
+                    pending.pop_front();
+                }
+                classifyBlock(job.second, out, mode);
+                std::lock_guard<std::mutex> guard(lock);
+                finished.emplace(job.first, std::move(out));
+                out = std::string();
+                changed.notify_all();
+            }
+        });
+    }
+
+    size_t next_block = 0;
+    while (true) {
+        std::string text;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() {
+                return finished.count(next_block) != 0 || (reading_done && next_block == blocks_read);
+            });
+            auto ready = finished.find(next_block);
+            if (ready == finished.end()) break;
+            text = std::move(ready->second);
+            finished.erase(ready);
+        }
+        output.writeString(text);
+        output.flush();
+        ++next_block;
+        std::lock_guard<std::mutex> guard(lock);
+        --in_flight;
+        changed.notify_all();
+    }
+
+    reader.join();
+    for (auto& worker : pool) worker.join();
+}
+
+int main(int argc, char* argv[]) {
+    CheckMode mode = CheckMode::Fast;
+    unsigned threads = 1;
+    for (int a = 1; a < argc; ++a) {
+        if (std::strcmp(argv[a], "--reference") == 0) {
+            mode = CheckMode::Reference;
+        } else if (std::strcmp(argv[a], "--utf8") == 0) {
+            mode = CheckMode::Utf8;
+        } else if (std::strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+            if (!parseThreadCount(argv[++a], threads)) return 1;
+        }
+    }
+    FastInput input;
+    FastOutput output;
+    if (threads > 1) {
+        runPipeline(input, output, threads, mode);
+        return 0;
+    }
     std::string line;
-    while (std::getline(std::cin, line)) {
+    while (input.readLine(line)) {
         // Remove leading/trailing spaces if any.
         // Check if the phrase is a palindrome permutation, by passing it to the true/false function to check if the letters have the correct amounts of
                 // each.
-        if (is_palindrome_permutation(line)) {
-            std::cout << "\"" << line << "\" is a palindrome permutation" << std::endl;
+        bool palindrome = checkLine(mode, line.data(), line.size());
+        output.writeChar('"');
+        output.writeString(line);
+        if (palindrome) {
+            output.writeString("\" is a palindrome permutation\n");
         } else {
-            std::cout << "\"" << line << "\" is not a palindrome permutation" << std::endl;
+            output.writeString("\" is not a palindrome permutation\n");
         }
     }
     return 0;
@@ -1,6 +1,13 @@
 //Jonathan Attanasio
 //This program takes an input and determines if there is an edge between the two nodes in the graph.
 //It checks this by DFS.
+//Node names are interned to integer ids when a graph is read and the edges are frozen into CSR arrays,
+//so a query never hashes a string past its two endpoints. --reference runs the original string based DFS.
+//The DFS keeps its own stack so deep chains cannot overflow the call stack, and --bidirectional answers with
+//a BFS that grows from both ends over the forward and reverse edges instead. --index precomputes a reachability
+//index per graph (strongly connected components plus DAG labels) so most queries need no traversal at all, and
+//--stats reports its build time, size and query latency on stderr. --threads N answers the queries of each graph
+//on N threads (0 picks one per core) and still prints them in input order; build with -pthread.
 
 #include <iostream>
 #include <vector>
@@ -8,6 +15,18 @@
 #include <unordered_set>
 #include <string>
 #include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <atomic>
+#include <thread>
+#include "fastio.h"
+#include "threads.h"
 
 using namespace std;
 
@@ -42,7 +61,586 @@ bool check_path(const unordered_map<string, vector<string>>& graph, const string
     return dfs(graph, src, dest, visited);
 }
 
-int main() {
+// How a path query searches the graph
+enum class Search { Dfs, Bidirectional, Index };
+
+// Working memory for path queries. The frozen graph is only ever read, so every thread that
+// searches it just needs one of these of its own.
+struct SearchScratch {
+    vector<uint32_t> visited;       // Epoch of the last query that reached each node
+    vector<uint32_t> visited_back;  // Epoch stamps of the backward search
+    uint32_t epoch = 0;
+    size_t explored = 0;            // Nodes the last query marked as reached
+    vector<pair<int, uint32_t>> stack;
+    vector<int> forward, backward, next_frontier;
+
+    // Starts a query over (at least) the given number of nodes. Bumping the epoch unmarks every
+    // node at once, the arrays are only cleared when it wraps around.
+    void begin(size_t nodes, bool backward_search) {
+        explored = 0;
+        if (visited.size() < nodes) visited.assign(nodes, 0), visited_back.clear(), epoch = 0;
+        if (backward_search && visited_back.size() < visited.size()) visited_back.assign(visited.size(), 0);
+        if (++epoch == 0) { // Wrapped around, old stamps could match again
+            std::fill(visited.begin(), visited.end(), 0);
+            std::fill(visited_back.begin(), visited_back.end(), 0);
+            epoch = 1;
+        }
+    }
+};
+
+// A graph whose node names are interned to dense ids at load time and whose edges are frozen
+// into compressed sparse row arrays: the targets of node u are targets[offsets[u] .. offsets[u + 1]),
+// in the order the edges were read
+class CsrGraph {
+public:
+    // Returns the id for name, handing out the next one the first time it is seen
+    int intern(const string& name) {
+        auto found = ids.find(name);
+        if (found != ids.end()) return found->second;
+        int id = static_cast<int>(ids.size());
+        ids.emplace(name, id);
+        return id;
+    }
+
+    void addEdge(const string& src, const string& dst) {
+        int from = intern(src);
+        int to = intern(dst);
+        edges.push_back({from, to});
+    }
+
+    // Lays the edge list out as CSR with a stable counting sort on the source id
+    void freeze() {
+        size_t nodes = ids.size();
+        offsets.assign(nodes + 1, 0);
+        for (const auto& edge : edges) offsets[edge.first + 1]++;
+        for (size_t u = 0; u < nodes; ++u) offsets[u + 1] += offsets[u];
+        targets.resize(edges.size());
+        vector<int> next(offsets.begin(), offsets.end() - 1);
+        for (const auto& edge : edges) targets[next[edge.first]++] = edge.second;
+        edges.clear();
+        edges.shrink_to_fit();
+        reverse_offsets.clear();
+    }
+
+    // Builds whatever a search needs beyond the CSR (the reverse edges for bidirectional
+    // search), so that the const queries below can then run from several threads at once
+    void prepare(Search search) {
+        if (search == Search::Bidirectional && reverse_offsets.empty()) buildReverse();
+    }
+
+    // Id of a node, -1 when the name never appeared in an edge
+    int find(const string& name) const {
+        auto found = ids.find(name);
+        return found == ids.end() ? -1 : found->second;
+    }
+
+    size_t nodeCount() const { return ids.size(); }
+
+    // Out-neighbours of u as a [first, last) range into the CSR targets
+    const int* neighborsBegin(int u) const { return targets.data() + offsets[u]; }
+    const int* neighborsEnd(int u) const { return targets.data() + offsets[u + 1]; }
+
+    // Nodes the last query through the single threaded hasPath marked as reached, for
+    // comparing search strategies
+    size_t lastExplored() const { return own_scratch.explored; }
+
+    // Same answers as check_path, using the caller's scratch. prepare(search) must have run.
+    bool hasPath(int src, int dest, Search search, SearchScratch& scratch) const {
+        scratch.explored = 0;
+        if (src < 0 || dest < 0) return false;
+        if (src == dest) return true;
+        scratch.begin(nodeCount(), search == Search::Bidirectional);
+        return search == Search::Bidirectional ? bidirectionalBfs(src, dest, scratch) : dfs(src, dest, scratch);
+    }
+
+    // Single threaded convenience version with scratch owned by the graph
+    bool hasPath(int src, int dest, Search search = Search::Dfs) {
+        prepare(search);
+        return hasPath(src, dest, search, own_scratch);
+    }
+
+private:
+    // Depth first search with an explicit stack of (node, next edge) frames. It visits nodes in
+    // exactly the order the recursive dfs did, but its depth is only limited by memory.
+    bool dfs(int src, int dest, SearchScratch& scratch) const {
+        auto& stack = scratch.stack;
+        auto& visited = scratch.visited;
+        const uint32_t epoch = scratch.epoch;
+        stack.clear();
+        visited[src] = epoch;
+        ++scratch.explored;
+        stack.push_back({src, offsets[src]});
+        while (!stack.empty()) {
+            auto& frame = stack.back();
+            if (frame.second == offsets[frame.first + 1]) {
+                stack.pop_back();
+                continue;
+            }
+            int v = targets[frame.second++];
+            if (v == dest) return true;
+            if (visited[v] == epoch) continue;
+            visited[v] = epoch;
+            ++scratch.explored;
+            stack.push_back({v, offsets[v]});
+        }
+        return false;
+    }
+
+    // Lays out the reverse edges for bidirectional search
+    void buildReverse() {
+        size_t nodes = ids.size();
+        reverse_offsets.assign(nodes + 1, 0);
+        for (int v : targets) reverse_offsets[v + 1]++;
+        for (size_t u = 0; u < nodes; ++u) reverse_offsets[u + 1] += reverse_offsets[u];
+        reverse_targets.resize(targets.size());
+        vector<uint32_t> next(reverse_offsets.begin(), reverse_offsets.end() - 1);
+        for (size_t u = 0; u < nodes; ++u) {
+            for (uint32_t e = offsets[u]; e < offsets[u + 1]; ++e) {
+                reverse_targets[next[targets[e]]++] = static_cast<int>(u);
+            }
+        }
+    }
+
+    // Expands one BFS level of a frontier. Returns true as soon as it reaches a node the other
+    // side has already seen.
+    static bool expandLevel(vector<int>& frontier, const vector<uint32_t>& edge_offsets, const vector<int>& edge_targets,
+                            vector<uint32_t>& seen, const vector<uint32_t>& other_seen, SearchScratch& scratch) {
+        const uint32_t epoch = scratch.epoch;
+        auto& next_frontier = scratch.next_frontier;
+        next_frontier.clear();
+        for (int u : frontier) {
+            for (uint32_t e = edge_offsets[u]; e < edge_offsets[u + 1]; ++e) {
+                int v = edge_targets[e];
+                if (other_seen[v] == epoch) return true;
+                if (seen[v] == epoch) continue;
+                seen[v] = epoch;
+                ++scratch.explored;
+                next_frontier.push_back(v);
+            }
+        }
+        frontier.swap(next_frontier);
+        return false;
+    }
+
+    // Breadth first search from src over the edges and from dest over the reversed edges,
+    // always growing the smaller frontier, until the two meet or one side runs out
+    bool bidirectionalBfs(int src, int dest, SearchScratch& scratch) const {
+        auto& forward = scratch.forward;
+        auto& backward = scratch.backward;
+        forward.assign(1, src);
+        backward.assign(1, dest);
+        scratch.visited[src] = scratch.epoch;
+        scratch.visited_back[dest] = scratch.epoch;
+        scratch.explored = 2;
+        while (!forward.empty() && !backward.empty()) {
+            bool met = (forward.size() <= backward.size())
+                           ? expandLevel(forward, offsets, targets, scratch.visited, scratch.visited_back, scratch)
+                           : expandLevel(backward, reverse_offsets, reverse_targets, scratch.visited_back, scratch.visited, scratch);
+            if (met) return true;
+        }
+        return false;
+    }
+
+    unordered_map<string, int> ids;
+    vector<pair<int, int>> edges;      // Only kept until freeze()
+    vector<uint32_t> offsets;
+    vector<int> targets;
+    vector<uint32_t> reverse_offsets;  // Reverse CSR, built by prepare() for bidirectional search
+    vector<int> reverse_targets;
+    SearchScratch own_scratch;         // Used by the single threaded hasPath
+};
+
+// Precomputed reachability for one frozen graph. The strongly connected components are found
+// with Tarjan's algorithm and condensed into a DAG. Tarjan numbers components sinks first, so
+// every DAG edge goes from a higher id to a lower one and a lower id can never reach a higher
+// one. On top of that:
+//  - DAGs of up to CLOSURE_LIMIT components keep the full transitive closure as one bitset per
+//    component, and every query is a single bit test.
+//  - Larger DAGs get GRAIL interval labels: for each of LABELINGS randomised post-order
+//    traversals, component c gets [low, rank] where rank is its post-order number and low the
+//    smallest rank below it. If d is reachable from c then d's interval sits inside c's in every
+//    labeling, so one failed containment answers "no" in O(LABELINGS). Only the remaining
+//    candidates run a DFS over the DAG that skips children failing the same tests.
+class ReachabilityIndex {
+public:
+    static const size_t CLOSURE_LIMIT = 8192;
+    static const int LABELINGS = 3;
+
+    explicit ReachabilityIndex(const CsrGraph& graph) {
+        findComponents(graph);
+        buildDag(graph);
+        if (components <= CLOSURE_LIMIT) {
+            buildClosure();
+        } else {
+            buildLabels();
+        }
+    }
+
+    // Safe to call from several threads as long as each passes its own scratch
+    bool reachable(int src, int dest, SearchScratch& scratch) const {
+        if (src < 0 || dest < 0) return false;
+        if (src == dest) return true;
+        int from = component[src];
+        int to = component[dest];
+        if (from == to) return true;  // Two nodes of one SCC reach each other
+        if (from < to) return false;  // Against the topological order
+        if (!closure.empty()) {
+            return (closure[static_cast<size_t>(from) * closure_words + to / 64] >> (to % 64)) & 1;
+        }
+        if (!contains(from, to)) return false;
+        return prunedSearch(from, to, scratch);
+    }
+
+    // Single threaded convenience version with scratch owned by the index
+    bool reachable(int src, int dest) { return reachable(src, dest, own_scratch); }
+
+    size_t componentCount() const { return components; }
+    bool usesClosure() const { return !closure.empty(); }
+
+    // Bytes held by the index itself, not counting the graph
+    size_t memoryBytes() const {
+        return component.capacity() * sizeof(int) + dag_offsets.capacity() * sizeof(uint32_t) +
+               dag_targets.capacity() * sizeof(int) + closure.capacity() * sizeof(uint64_t) +
+               labels.capacity() * sizeof(Interval);
+    }
+
+private:
+    struct Interval {
+        uint32_t low;
+        uint32_t rank;
+    };
+
+    // Iterative Tarjan, so long chains do not exhaust the call stack
+    void findComponents(const CsrGraph& graph) {
+        size_t n = graph.nodeCount();
+        component.assign(n, -1);
+        vector<int> order(n, -1), low(n, 0), tarjan_stack;
+        vector<char> on_stack(n, 0);
+        vector<pair<int, const int*>> frames;  // Node and its next unexplored neighbour
+        int counter = 0;
+        components = 0;
+        for (size_t start = 0; start < n; ++start) {
+            if (order[start] != -1) continue;
+            order[start] = low[start] = counter++;
+            tarjan_stack.push_back(static_cast<int>(start));
+            on_stack[start] = 1;
+            frames.push_back({static_cast<int>(start), graph.neighborsBegin(static_cast<int>(start))});
+            while (!frames.empty()) {
+                int u = frames.back().first;
+                const int*& next = frames.back().second;
+                if (next != graph.neighborsEnd(u)) {
+                    int v = *next++;
+                    if (order[v] == -1) {
+                        order[v] = low[v] = counter++;
+                        tarjan_stack.push_back(v);
+                        on_stack[v] = 1;
+                        frames.push_back({v, graph.neighborsBegin(v)});
+                    } else if (on_stack[v]) {
+                        low[u] = min(low[u], order[v]);
+                    }
+                    continue;
+                }
+                frames.pop_back();
+                if (low[u] == order[u]) {
+                    int member;
+                    do {
+                        member = tarjan_stack.back();
+                        tarjan_stack.pop_back();
+                        on_stack[member] = 0;
+                        component[member] = static_cast<int>(components);
+                    } while (member != u);
+                    ++components;
+                }
+                if (!frames.empty()) {
+                    int parent = frames.back().first;
+                    low[parent] = min(low[parent], low[u]);
+                }
+            }
+        }
+    }
+
+    // Condensed edges, one per pair of components, as CSR
+    void buildDag(const CsrGraph& graph) {
+        size_t n = graph.nodeCount();
+        vector<int> members(n);
+        vector<uint32_t> member_offsets(components + 1, 0);
+        for (size_t u = 0; u < n; ++u) member_offsets[component[u] + 1]++;
+        for (size_t c = 0; c < components; ++c) member_offsets[c + 1] += member_offsets[c];
+        vector<uint32_t> fill(member_offsets.begin(), member_offsets.end() - 1);
+        for (size_t u = 0; u < n; ++u) members[fill[component[u]]++] = static_cast<int>(u);
+
+        vector<int> last_added(components, -1);
+        dag_offsets.assign(components + 1, 0);
+        dag_targets.clear();
+        for (size_t c = 0; c < components; ++c) {
+            for (uint32_t m = member_offsets[c]; m < member_offsets[c + 1]; ++m) {
+                for (const int* v = graph.neighborsBegin(members[m]); v != graph.neighborsEnd(members[m]); ++v) {
+                    int target = component[*v];
+                    if (target == static_cast<int>(c) || last_added[target] == static_cast<int>(c)) continue;
+                    last_added[target] = static_cast<int>(c);
+                    dag_targets.push_back(target);
+                }
+            }
+            dag_offsets[c + 1] = static_cast<uint32_t>(dag_targets.size());
+        }
+        dag_targets.shrink_to_fit();
+    }
+
+    // Components are finished sinks first, so every child's row is complete before its parents
+    void buildClosure() {
+        closure_words = (components + 63) / 64;
+        closure.assign(components * closure_words, 0);
+        for (size_t c = 0; c < components; ++c) {
+            uint64_t* row = &closure[c * closure_words];
+            for (uint32_t e = dag_offsets[c]; e < dag_offsets[c + 1]; ++e) {
+                size_t child = static_cast<size_t>(dag_targets[e]);
+                row[child / 64] |= uint64_t(1) << (child % 64);
+                const uint64_t* child_row = &closure[child * closure_words];
+                for (size_t w = 0; w < closure_words; ++w) row[w] |= child_row[w];
+            }
+        }
+    }
+
+    void buildLabels() {
+        labels.assign(static_cast<size_t>(LABELINGS) * components, {0, 0});
+        vector<uint32_t> seen(components, 0);  // Labeling number that last reached each component
+        uint32_t epoch = 0;
+        vector<int> roots(components);
+        for (size_t c = 0; c < components; ++c) roots[c] = static_cast<int>(c);
+        vector<pair<int, uint32_t>> frames;  // Component and how many children it has walked
+        std::mt19937 random(12345);           // Fixed seed so runs are reproducible
+        for (int k = 0; k < LABELINGS; ++k) {
+            Interval* label = &labels[static_cast<size_t>(k) * components];
+            std::shuffle(roots.begin(), roots.end(), random);
+            bool reversed = (k % 2 == 1);
+            uint32_t rank = 0;
+            ++epoch;
+            for (int root : roots) {
+                if (seen[root] == epoch) continue;
+                seen[root] = epoch;
+                frames.push_back({root, 0});
+                label[root].low = UINT32_MAX;
+                while (!frames.empty()) {
+                    int c = frames.back().first;
+                    uint32_t degree = dag_offsets[c + 1] - dag_offsets[c];
+                    if (frames.back().second < degree) {
+                        uint32_t step = frames.back().second++;
+                        int child = dag_targets[dag_offsets[c] + (reversed ? degree - 1 - step : step)];
+                        if (seen[child] != epoch) {
+                            seen[child] = epoch;
+                            label[child].low = UINT32_MAX;
+                            frames.push_back({child, 0});
+                        } else {
+                            label[c].low = min(label[c].low, label[child].low);
+                        }
+                        continue;
+                    }
+                    frames.pop_back();
+                    label[c].rank = rank++;
+                    label[c].low = min(label[c].low, label[c].rank);
+                    if (!frames.empty()) {
+                        int parent = frames.back().first;
+                        label[parent].low = min(label[parent].low, label[c].low);
+                    }
+                }
+            }
+        }
+    }
+
+    // Whether to's interval lies inside from's in every labeling
+    bool contains(int from, int to) const {
+        for (int k = 0; k < LABELINGS; ++k) {
+            const Interval& outer = labels[static_cast<size_t>(k) * components + from];
+            const Interval& inner = labels[static_cast<size_t>(k) * components + to];
+            if (inner.low < outer.low || inner.rank > outer.rank) return false;
+        }
+        return true;
+    }
+
+    // DFS over the DAG that only enters children which can still reach to
+    bool prunedSearch(int from, int to, SearchScratch& scratch) const {
+        scratch.begin(components, false);
+        vector<uint32_t>& seen = scratch.visited;
+        const uint32_t epoch = scratch.epoch;
+        vector<int>& stack = scratch.forward;
+        stack.clear();
+        stack.push_back(from);
+        seen[from] = epoch;
+        while (!stack.empty()) {
+            int c = stack.back();
+            stack.pop_back();
+            for (uint32_t e = dag_offsets[c]; e < dag_offsets[c + 1]; ++e) {
+                int child = dag_targets[e];
+                if (child == to) return true;
+                if (child < to || seen[child] == epoch || !contains(child, to)) continue;
+                seen[child] = epoch;
+                stack.push_back(child);
+            }
+        }
+        return false;
+    }
+
+    size_t components = 0;
+    vector<int> component;          // SCC id of every node
+    vector<uint32_t> dag_offsets;   // Condensation as CSR
+    vector<int> dag_targets;
+    size_t closure_words = 0;
+    vector<uint64_t> closure;       // Reachable components per component, small DAGs only
+    vector<Interval> labels;        // LABELINGS rows of intervals, large DAGs only
+    SearchScratch own_scratch;      // Used by the single threaded reachable
+};
+
+// Splits a line into its first two whitespace separated words, like ss >> src >> dst
+void splitPair(const string& line, string& first, string& second) {
+    const char* spaces = " \t\r\v\f";
+    size_t a = line.find_first_not_of(spaces);
+    size_t a_end = (a == string::npos) ? string::npos : line.find_first_of(spaces, a);
+    first = (a == string::npos) ? string() : line.substr(a, a_end - a);
+    size_t b = (a_end == string::npos) ? string::npos : line.find_first_not_of(spaces, a_end);
+    size_t b_end = (b == string::npos) ? string::npos : line.find_first_of(spaces, b);
+    second = (b == string::npos) ? string() : line.substr(b, b_end - b);
+}
+
+// Writes one query result in the usual format
+void writeAnswer(FastOutput& output, int graph_count, const string& src, const string& dst, bool found) {
+    output.writeString("In Graph ");
+    output.writeInt(graph_count);
+    output.writeString(found ? " there is a path from " : " there is no path from ");
+    output.writeString(src);
+    output.writeString(" to ");
+    output.writeString(dst);
+    output.writeChar('\n');
+}
+
+// Queries a worker claims at a time. An index query, the cheapest kind, takes about 1.5 us on a
+// 200K node graph, some fifteen contended fetch_adds, so 256 of them make the counter noise;
+// a graph with fewer than 256 queries per thread just starts fewer threads.
+const size_t QUERY_BATCH = 256;
+
+// Answers queries[i] into found[i] with the given number of threads. Each thread claims
+// batches of queries and searches with its own scratch, the graph and index are only read.
+void answerQueries(CsrGraph& graph, const ReachabilityIndex* index, Search search,
+                   const vector<pair<string, string>>& queries, vector<char>& found, unsigned threads) {
+    graph.prepare(search);
+    const CsrGraph& frozen = graph;
+    atomic<size_t> next_query(0);
+    auto worker = [&]() {
+        SearchScratch scratch;
+        while (true) {
+            size_t first = next_query.fetch_add(QUERY_BATCH);
+            if (first >= queries.size()) break;
+            size_t last = min(first + QUERY_BATCH, queries.size());
+            for (size_t i = first; i < last; ++i) {
+                const string& src = queries[i].first;
+                const string& dst = queries[i].second;
+                // Equal names are a path even when the node is not in the graph, as in dfs
+                int from = frozen.find(src);
+                int to = frozen.find(dst);
+                found[i] = (src == dst) ||
+                           (index ? index->reachable(from, to, scratch) : frozen.hasPath(from, to, search, scratch));
+            }
+        }
+    };
+
+    size_t batches = (queries.size() + QUERY_BATCH - 1) / QUERY_BATCH;
+    size_t helpers = min<size_t>(threads, batches);
+    vector<thread> pool;
+    for (size_t t = 1; t < helpers; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+}
+
+// Reads and answers every graph using the interned CSR representation. A negative query count
+// prints a message on stderr and returns false.
+bool runCsr(Search search, bool stats, unsigned threads) {
+    FastInput input;
+    FastOutput output;
+    string line, src, dst;
+    int graph_count = 1;
+    vector<pair<string, string>> queries;
+    vector<char> found;
+
+    while (input.readLine(line)) {
+        // Read number of edges
+        int n_edges = stoi(line);
+        CsrGraph graph;
+
+        // Read edges
+        for (int i = 0; i < n_edges; ++i) {
+            input.readLine(line);
+            splitPair(line, src, dst);
+            graph.addEdge(src, dst);
+        }
+        graph.freeze();
+
+        // Read number of paths and the queries themselves, so they can be answered together
+        input.readLine(line);
+        int n_paths = stoi(line);
+        if (n_paths < 0) {
+            fprintf(stderr, "graph %d: query count must be 0 or more, got %d\n", graph_count, n_paths);
+            return false;
+        }
+        queries.resize(n_paths);
+        for (int i = 0; i < n_paths; ++i) {
+            input.readLine(line);
+            splitPair(line, queries[i].first, queries[i].second);
+        }
+
+        auto build_start = chrono::steady_clock::now();
+        unique_ptr<ReachabilityIndex> index;
+        if (search == Search::Index) index.reset(new ReachabilityIndex(graph));
+        auto query_start = chrono::steady_clock::now();
+
+        // Check paths
+        found.assign(n_paths, 0);
+        answerQueries(graph, index.get(), search, queries, found, threads);
+        auto query_end = chrono::steady_clock::now();
+
+        for (int i = 0; i < n_paths; ++i) {
+            writeAnswer(output, graph_count, queries[i].first, queries[i].second, found[i] != 0);
+        }
+
+        if (stats) {
+            double build_ms = chrono::duration<double, milli>(query_start - build_start).count();
+            double query_us = chrono::duration<double, micro>(query_end - query_start).count();
+            fprintf(stderr, "graph %d: %zu nodes, %d queries on %u threads, %.2f us/query", graph_count,
+                    graph.nodeCount(), n_paths, threads, n_paths > 0 ? query_us / n_paths : 0.0);
+            if (index) {
+                fprintf(stderr, ", index %s over %zu components, %zu bytes, built in %.2f ms",
+                        index->usesClosure() ? "closure" : "intervals", index->componentCount(),
+                        index->memoryBytes(), build_ms);
+            }
+            fprintf(stderr, "\n");
+        }
+
+        graph_count++;
+        output.writeChar('\n'); // Print an empty line between graphs
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool reference = false;
+    bool stats = false;
+    unsigned threads = 1;
+    Search search = Search::Dfs;
+    for (int a = 1; a < argc; ++a) {
+        if (strcmp(argv[a], "--reference") == 0) {
+            reference = true;
+        } else if (strcmp(argv[a], "--bidirectional") == 0) {
+            search = Search::Bidirectional;
+        } else if (strcmp(argv[a], "--index") == 0) {
+            search = Search::Index;
+        } else if (strcmp(argv[a], "--stats") == 0) {
+            stats = true;
+        } else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+            if (!parseThreadCount(argv[++a], threads)) return 1;
+        }
+    }
+    if (!reference) {
+        return runCsr(search, stats, threads) ? 0 : 1;
+    }
+
     string line;
     int graph_count = 1;
 
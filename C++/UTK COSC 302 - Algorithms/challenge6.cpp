@@ -1,59 +1,462 @@
 // Challenge 6: Minimum Spanning Tree - Jonathan Attanasio
 // This program uses Prim's algorithm to find the MST in a graph. The graph is given by the input file.
 // This is then iterated over to find the smallest total weight to visit each node.
+// By default each graph is a vertex count followed by a V x V distance matrix (-1 for no edge). With --edges
+// each graph is instead "V E" followed by E lines "u v weight" with 0 based vertex numbers, so sparse graphs
+// never need a matrix. Edge lists pick the engine by density: the matrix scan for dense graphs, Prim with an
+// indexed heap over adjacency arrays for sparse ones. A matrix input already paid for its V x V read, so it
+// stays on the matrix scan unless told otherwise. --engine dense|heap|kruskal|boruvka forces one; Kruskal breaks
+// ties between equal weights by vertex numbers, so on graphs with tied weights it can print a different tree of
+// the same total weight. An edge list with an edge of weight -1 runs the dense engine's part on the heap engine,
+// since -1 means no edge in the matrix. Boruvka runs on --threads N (0 picks one per core, build with -pthread) and is picked
+// for large sparse edge lists when N > 1. It prints exactly the Prim tree, falling back to Prim when tied weights
+// leave more than one minimum tree, and treats the graph as undirected. --scaling times it on 1, 2, 4, ... up to
+// N threads and reports the speedups on stderr. Trees with a vertex past Z print their edges as "u v" with
+// 0 based numbers instead of letter pairs, as does every tree with --numeric. Total weights are 64-bit.
 
-#include <iostream>
 #include <vector>
-#include <queue>
 #include <climits>
+#include <cstring>
 #include <algorithm>
+#include <numeric>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include "fastio.h"
+#include "threads.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define MST_HAVE_AVX2 1
+#endif
 
 using namespace std;
 
-// Function to print the MST result and formatted appropriately for output
-void printMST(int total_weight, vector<pair<int, int>>& mst_edges) {
-    cout << total_weight << endl;
-    sort(mst_edges.begin(), mst_edges.end(), [](pair<int, int> a, pair<int, int> b) {
-        if (a.first == b.first) return a.second < b.second;
-        return a.first < b.first;
-    });
+// Buffered stdin/stdout shared by main and printMST
+FastInput input;
+FastOutput output;
+
+// Set by --numeric: print vertices as 0 based numbers even when they would fit in A..Z
+bool numeric_names = false;
+
+// One weighted edge of the input
+struct Edge {
+    int u, v, weight;
+};
+
+// Which MST algorithm runs on a graph
+enum class MstEngine { Auto, Dense, Heap, Kruskal, Boruvka };
+
+// Engine choice and parallelism for one run
+struct MstOptions {
+    MstEngine engine = MstEngine::Auto;
+    unsigned threads = 1;
+    bool scaling = false;  // Report a strong-scaling run of Boruvka on stderr
+};
+
+// Edge lists with at least this fraction of all possible arcs go to the dense matrix scan. Below
+// it the heap engine was faster in testing, even counting the matrix the dense engine has to fill.
+const double DENSE_FRACTION = 0.5;
+
+// Sparse edge lists with at least this many arcs go to Boruvka when more than one thread is allowed
+const size_t BORUVKA_MIN_ARCS = 1 << 20;
+
+// edgeRank keeps an edge's index in 32 bits, so edge lists with this many arcs or more run on the
+// heap engine even when Boruvka is asked for
+const uint64_t BORUVKA_MAX_ARCS = uint64_t(1) << 32;
+
+// Most edges an edge list header can make readEdgeList reserve room for up front
+const long long EDGE_RESERVE_LIMIT = 1 << 22;
+
+// Adjacency arrays: the neighbours of u are target[offset[u] .. offset[u + 1]) with matching weights.
+// Arcs are directed so a matrix row maps onto exactly one range, edge lists add both directions.
+struct AdjacencyGraph {
+    int vertices = 0;
+    vector<int> offset;
+    vector<int> target;
+    vector<int> weight;
+
+    // Lays out arcs (u -> v) with a counting sort on u, keeping their input order within each u
+    void build(int n, const vector<Edge>& arcs) {
+        vertices = n;
+        offset.assign(n + 1, 0);
+        for (const Edge& arc : arcs) offset[arc.u + 1]++;
+        partial_sum(offset.begin(), offset.end(), offset.begin());
+        target.resize(arcs.size());
+        weight.resize(arcs.size());
+        vector<int> next(offset.begin(), offset.end() - 1);
+        for (const Edge& arc : arcs) {
+            int slot = next[arc.u]++;
+            target[slot] = arc.v;
+            weight[slot] = arc.weight;
+        }
+    }
+};
+
+// Min-heap of vertices keyed by their current edge weight, with a position index so a key can be
+// lowered in place instead of pushing duplicates. Equal keys pop the lower vertex first, the same
+// order the dense engine picks vertices in.
+class IndexedHeap {
+public:
+    explicit IndexedHeap(int vertices) : key(vertices, INT_MAX), pos(vertices, -1) {}
+
+    bool empty() const { return heap.empty(); }
+    bool popped(int v) const { return pos[v] == -2; }
+    int keyOf(int v) const { return key[v]; }
+
+    // Inserts v or lowers its key, whichever applies
+    void pushOrDecrease(int v, int new_key) {
+        key[v] = new_key;
+        if (pos[v] < 0) {
+            pos[v] = static_cast<int>(heap.size());
+            heap.push_back(v);
+        }
+        siftUp(pos[v]);
+    }
+
+    int popMin() {
+        int top = heap[0];
+        pos[top] = -2;  // Popped for good
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            pos[last] = 0;
+            siftDown(0);
+        }
+        return top;
+    }
+
+private:
+    static const int ARITY = 4;  // Shallower than a binary heap, and the children share a cache line
+
+    bool less(int a, int b) const { return key[a] < key[b] || (key[a] == key[b] && a < b); }
+
+    void place(int i, int v) {
+        heap[i] = v;
+        pos[v] = i;
+    }
+
+    void siftUp(int i) {
+        int v = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) / ARITY;
+            if (!less(v, heap[parent])) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, v);
+    }
+
+    void siftDown(int i) {
+        int v = heap[i];
+        int n = static_cast<int>(heap.size());
+        while (true) {
+            int first = i * ARITY + 1;
+            if (first >= n) break;
+            int best = first;
+            for (int c = first + 1; c < min(first + ARITY, n); ++c) {
+                if (less(heap[c], heap[best])) best = c;
+            }
+            if (!less(heap[best], v)) break;
+            place(i, heap[best]);
+            i = best;
+        }
+        place(i, v);
+    }
+
+    vector<int> key;
+    vector<int> pos;   // Index in heap, -1 before the first push and -2 once popped
+    vector<int> heap;
+};
+
+// Disjoint sets with path compression and union by rank
+class UnionFind {
+public:
+    explicit UnionFind(int n) : parent(n), rank(n, 0) { iota(parent.begin(), parent.end(), 0); }
+
+    int find(int x) {
+        int root = x;
+        while (parent[root] != root) root = parent[root];
+        while (parent[x] != root) {
+            int next = parent[x];
+            parent[x] = root;
+            x = next;
+        }
+        return root;
+    }
+
+    // Joins the sets of a and b, false when they already were one set
+    bool unite(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        if (rank[a] < rank[b]) swap(a, b);
+        parent[b] = a;
+        if (rank[a] == rank[b]) rank[a]++;
+        return true;
+    }
+
+private:
+    vector<int> parent;
+    vector<int> rank;
+};
+
+// Puts the tree edges in (first, second) order. Large trees use two stable counting sort passes
+// (by second, then by first), O(E + V) instead of a comparison sort over millions of pairs.
+void sortEdgePairs(vector<pair<int, int>>& mst_edges) {
+    if (mst_edges.size() < 4096) {
+        sort(mst_edges.begin(), mst_edges.end());
+        return;
+    }
+    int top = 0;
+    for (auto edge : mst_edges) top = max(top, edge.second + 1);  // Pairs are (min, max)
+    vector<pair<int, int>> sorted(mst_edges.size());
+    vector<size_t> start(top + 1);
+    for (int pass = 0; pass < 2; ++pass) {
+        fill(start.begin(), start.end(), 0);
+        for (auto edge : mst_edges) start[(pass == 0 ? edge.second : edge.first) + 1]++;
+        partial_sum(start.begin(), start.end(), start.begin());
+        for (auto edge : mst_edges) sorted[start[pass == 0 ? edge.second : edge.first]++] = edge;
+        mst_edges.swap(sorted);
+    }
+}
+
+// Function to print the MST result and formatted appropriately for output. Vertices print as the
+// letters A..Z while the whole tree fits in them, otherwise (or with --numeric) each edge is a line
+// "u v" with 0 based vertex numbers.
+void printMST(long long total_weight, vector<pair<int, int>>& mst_edges) {
+    output.writeInt(total_weight);
+    output.writeChar('\n');
+    sortEdgePairs(mst_edges);
+    bool letters = !numeric_names;
+    for (auto edge : mst_edges) {
+        if (edge.second >= 26) letters = false;  // Pairs are (min, max)
+    }
     for (auto edge : mst_edges) {
-        cout << char('A' + edge.first) << char('A' + edge.second) << endl;
+        if (letters) {
+            output.writeChar(char('A' + edge.first));
+            output.writeChar(char('A' + edge.second));
+        } else {
+            output.writeInt(edge.first);
+            output.writeChar(' ');
+            output.writeInt(edge.second);
+        }
+        output.writeChar('\n');
     }
 }
 
-int primMST(int vertices, const vector<vector<int>>& matrix) {
-    vector<bool> in_mst(vertices, false);  // Track vertices included in MST
-    vector<int> min_edge(vertices, INT_MAX);  // Store the minimum edge weight to each vertex
-    vector<int> parent(vertices, -1);  // Store the parent vertex for each vertex
-    min_edge[0] = 0;  // Start from vertex A (index 0)
+// The dense engine keeps, for every vertex, the lightest edge seen into the tree so far (key, INT_MAX
+// for none), the tree vertex on the other end (parent) and whether it joined the tree (done, 0 or -1 so
+// it works as a SIMD mask). Vertices in the tree have their key reset to INT_MAX so the arg-min skips them.
+struct DenseState {
+    vector<int> key;
+    vector<int> parent;
+    vector<int> done;
+};
 
-    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;  // Min-heap
-    pq.push({0, 0});  // {edge_weight, vertex}
+// Relaxes columns [v, end) of row u and returns the lightest remaining vertex among them, lowest
+// index on ties, or -1 when none has an edge to the tree
+int relaxRowScalar(const int* row, int u, DenseState& state, int v, int end) {
+    int* key = state.key.data();
+    int* parent = state.parent.data();
+    const int* done = state.done.data();
+    int best = -1;
+    int best_key = INT_MAX;
+    for (; v < end; ++v) {
+        if (row[v] != -1 && !done[v] && row[v] < key[v]) {
+            key[v] = row[v];
+            parent[v] = u;
+        }
+        if (key[v] < best_key) {
+            best_key = key[v];
+            best = v;
+        }
+    }
+    return best;
+}
 
-    vector<pair<int, int>> mst_edges;  // To store the edges in the MST
-    int total_weight = 0;
+// Folds a candidate from another part of the row into the running arg-min
+void keepLighter(const DenseState& state, int candidate, int& best) {
+    if (candidate < 0) return;
+    if (best < 0 || state.key[candidate] < state.key[best] ||
+        (state.key[candidate] == state.key[best] && candidate < best)) {
+        best = candidate;
+    }
+}
+
+#if defined(__SSE2__)
+// a ? b : c on every lane, SSE2 has no blend instruction
+static inline __m128i select128(__m128i mask, __m128i b, __m128i c) {
+    return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, c));
+}
+
+// relaxRowScalar four columns at a time. Each lane keeps its own lightest key and the first column
+// it was seen in, the lanes are merged at the end.
+int relaxRowSSE2(const int* row, int u, DenseState& state, int end) {
+    int* key = state.key.data();
+    int* parent = state.parent.data();
+    const int* done = state.done.data();
+    const __m128i none = _mm_set1_epi32(-1);
+    const __m128i from = _mm_set1_epi32(u);
+    __m128i best_key = _mm_set1_epi32(INT_MAX);
+    __m128i best_idx = none;
+    __m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i step = _mm_set1_epi32(4);
+    int v = 0;
+    for (; v + 4 <= end; v += 4) {
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + v));
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + v));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(done + v));
+        __m128i lighter = _mm_cmplt_epi32(w, k);
+        __m128i skip = _mm_or_si128(d, _mm_cmpeq_epi32(w, none));
+        __m128i relax = _mm_andnot_si128(skip, lighter);
+        k = select128(relax, w, k);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(key + v), k);
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(parent + v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(parent + v), select128(relax, from, p));
+
+        __m128i better = _mm_cmplt_epi32(k, best_key);
+        best_key = select128(better, k, best_key);
+        best_idx = select128(better, idx, best_idx);
+        idx = _mm_add_epi32(idx, step);
+    }
+
+    alignas(16) int lane_idx[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lane_idx), best_idx);
+    int best = -1;
+    for (int lane = 0; lane < 4; ++lane) {
+        if (lane_idx[lane] >= 0 && key[lane_idx[lane]] != INT_MAX) keepLighter(state, lane_idx[lane], best);
+    }
+    keepLighter(state, relaxRowScalar(row, u, state, v, end), best);
+    return best;
+}
+#endif
+
+#if defined(MST_HAVE_AVX2)
+// relaxRowSSE2 with eight columns per step and real blends
+__attribute__((target("avx2")))
+int relaxRowAVX2(const int* row, int u, DenseState& state, int end) {
+    int* key = state.key.data();
+    int* parent = state.parent.data();
+    const int* done = state.done.data();
+    const __m256i none = _mm256_set1_epi32(-1);
+    const __m256i from = _mm256_set1_epi32(u);
+    __m256i best_key = _mm256_set1_epi32(INT_MAX);
+    __m256i best_idx = none;
+    __m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+    int v = 0;
+    for (; v + 8 <= end; v += 8) {
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + v));
+        __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + v));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(done + v));
+        __m256i lighter = _mm256_cmpgt_epi32(k, w);
+        __m256i skip = _mm256_or_si256(d, _mm256_cmpeq_epi32(w, none));
+        __m256i relax = _mm256_andnot_si256(skip, lighter);
+        k = _mm256_blendv_epi8(k, w, relax);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(key + v), k);
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(parent + v));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(parent + v), _mm256_blendv_epi8(p, from, relax));
+
+        __m256i better = _mm256_cmpgt_epi32(best_key, k);
+        best_key = _mm256_blendv_epi8(best_key, k, better);
+        best_idx = _mm256_blendv_epi8(best_idx, idx, better);
+        idx = _mm256_add_epi32(idx, step);
+    }
 
-    while (!pq.empty()) {
-        int u = pq.top().second;
-        int weight = pq.top().first;
-        pq.pop();
+    alignas(32) int lane_idx[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lane_idx), best_idx);
+    int best = -1;
+    for (int lane = 0; lane < 8; ++lane) {
+        if (lane_idx[lane] >= 0 && key[lane_idx[lane]] != INT_MAX) keepLighter(state, lane_idx[lane], best);
+    }
+    keepLighter(state, relaxRowScalar(row, u, state, v, end), best);
+    return best;
+}
+#endif
+
+// Relaxes all of row u with the widest kernel the CPU has
+int relaxRow(const int* row, int u, DenseState& state, int vertices) {
+#if defined(MST_HAVE_AVX2)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) return relaxRowAVX2(row, u, state, vertices);
+#endif
+#if defined(__SSE2__)
+    return relaxRowSSE2(row, u, state, vertices);
+#else
+    return relaxRowScalar(row, u, state, 0, vertices);
+#endif
+}
 
-        if (in_mst[u]) continue;  // Skip if already in MST, similar to Dijkstra's where there is a visited component to the code
+// Prim's algorithm on a flat row-major V x V matrix (-1 for no edge) with no heap at all: each step
+// relaxes the new tree vertex's row and picks the next vertex in the same pass, O(V^2) overall.
+// The next vertex is the lightest (weight, vertex) pair left, exactly what the earlier priority_queue
+// version popped, so the tree and the output are unchanged.
+long long primMST(int vertices, const vector<int>& matrix) {
+    vector<pair<int, int>> mst_edges;  // To store the edges in the MST
+    long long total_weight = 0;  // A sum of int weights can overflow an int
+    if (vertices == 0) {
+        printMST(total_weight, mst_edges);
+        return total_weight;
+    }
 
-        in_mst[u] = true;
+    DenseState state;
+    state.key.assign(vertices, INT_MAX);
+    state.parent.assign(vertices, -1);
+    state.done.assign(vertices, 0);
+
+    int u = 0;  // Start from vertex A (index 0)
+    int weight = 0;
+    while (u >= 0) {
+        state.done[u] = -1;
+        state.key[u] = INT_MAX;
         total_weight += weight;
+        if (state.parent[u] != -1) {
+            mst_edges.push_back({min(state.parent[u], u), max(state.parent[u], u)});
+        }
+
+        u = relaxRow(matrix.data() + static_cast<size_t>(u) * vertices, u, state, vertices);
+        if (u >= 0) weight = state.key[u];
+    }
+
+    printMST(total_weight, mst_edges);
+    return total_weight;
+}
 
+// Prim's algorithm over adjacency arrays, O(E log V). Vertices leave the heap in the same
+// (weight, vertex) order as in primMST and a parent only changes on a strictly lighter edge,
+// so it picks exactly the same tree.
+long long heapPrimMST(const AdjacencyGraph& graph) {
+    int vertices = graph.vertices;
+    vector<int> parent(vertices, -1);
+    vector<pair<int, int>> mst_edges;
+    long long total_weight = 0;
+    if (vertices == 0) {
+        printMST(total_weight, mst_edges);
+        return total_weight;
+    }
+
+    IndexedHeap heap(vertices);
+    heap.pushOrDecrease(0, 0);  // Start from vertex A (index 0)
+    while (!heap.empty()) {
+        int u = heap.popMin();
+        total_weight += heap.keyOf(u);
         if (parent[u] != -1) {
             mst_edges.push_back({min(parent[u], u), max(parent[u], u)});
         }
 
-        // Explore neighbors and push them into the priority queue
-        for (int v = 0; v < vertices; ++v) {
-            if (matrix[u][v] != -1 && !in_mst[v] && matrix[u][v] < min_edge[v]) {
-                min_edge[v] = matrix[u][v];
+        for (int e = graph.offset[u]; e < graph.offset[u + 1]; ++e) {
+            int v = graph.target[e];
+            int w = graph.weight[e];
+            if (!heap.popped(v) && w < heap.keyOf(v)) {
                 parent[v] = u;
-                pq.push({min_edge[v], v});
+                heap.pushOrDecrease(v, w);
             }
         }
     }
@@ -62,28 +465,414 @@ int primMST(int vertices, const vector<vector<int>>& matrix) {
     return total_weight;
 }
 
-int main() {
+// Kruskal's algorithm: edges by (weight, u, v), joined with union-find. Like the Prim versions it
+// only reports the tree of vertex A's component when the graph is disconnected.
+long long kruskalMST(int vertices, vector<Edge> edges) {
+    for (Edge& edge : edges) {
+        if (edge.u > edge.v) swap(edge.u, edge.v);
+    }
+    sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+        if (a.weight != b.weight) return a.weight < b.weight;
+        if (a.u != b.u) return a.u < b.u;
+        return a.v < b.v;
+    });
+
+    UnionFind sets(vertices);
+    vector<Edge> forest;
+    for (const Edge& edge : edges) {
+        if (edge.u != edge.v && sets.unite(edge.u, edge.v)) forest.push_back(edge);
+    }
+
+    vector<pair<int, int>> mst_edges;
+    long long total_weight = 0;
+    for (const Edge& edge : forest) {
+        if (sets.find(edge.u) != sets.find(0)) continue;
+        total_weight += edge.weight;
+        mst_edges.push_back({edge.u, edge.v});
+    }
+    printMST(total_weight, mst_edges);
+    return total_weight;
+}
+
+// Union-find that several threads can use at once. Roots are linked with a compare-and-swap, always
+// under the smaller index so racing links cannot form a cycle, and finds halve the paths they walk.
+class ConcurrentUnionFind {
+public:
+    explicit ConcurrentUnionFind(int n) : parent(n) {
+        for (int i = 0; i < n; ++i) parent[i].store(i, memory_order_relaxed);
+    }
+
+    int find(int x) {
+        while (true) {
+            int p = parent[x].load(memory_order_relaxed);
+            if (p == x) return x;
+            int grandparent = parent[p].load(memory_order_relaxed);
+            if (grandparent != p) parent[x].compare_exchange_weak(p, grandparent, memory_order_relaxed);
+            x = grandparent;
+        }
+    }
+
+    // Joins the sets of a and b, false when they already were one set. Exactly one of several
+    // threads uniting the same two sets gets true.
+    bool unite(int a, int b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return false;
+            if (a < b) swap(a, b);
+            int expected = a;
+            if (parent[a].compare_exchange_strong(expected, b)) return true;
+        }
+    }
+
+private:
+    vector<atomic<int>> parent;
+};
+
+// Orders edges by weight, then by position, packed so one 64-bit atomic min compares both. Borůvka
+// needs a strict order: with plain weights two components could pick tied edges that close a cycle.
+// The index has to fit in 32 bits, see BORUVKA_MAX_ARCS.
+inline uint64_t edgeRank(int weight, size_t index) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(weight) ^ 0x80000000u) << 32) | index;
+}
+
+inline void atomicMin(atomic<uint64_t>& slot, uint64_t value) {
+    uint64_t current = slot.load(memory_order_relaxed);
+    while (value < current && !slot.compare_exchange_weak(current, value, memory_order_relaxed)) {
+    }
+}
+
+// Borůvka's algorithm on the given number of threads. Each round every component finds its cheapest
+// outgoing edge (atomic mins over the edge list), all of them are merged through the concurrent
+// union-find, and edges that ended up inside one component are dropped. Returns the spanning forest
+// and leaves every vertex's component root in comp.
+vector<Edge> boruvkaForest(int vertices, vector<Edge> edges, unsigned threads, vector<int>& comp) {
+    const uint64_t NONE = UINT64_MAX;
+    ConcurrentUnionFind sets(vertices);
+    comp.resize(vertices);
+    iota(comp.begin(), comp.end(), 0);
+    vector<atomic<uint64_t>> cheapest(vertices);
+    vector<vector<Edge>> picked(threads);
+    vector<size_t> kept(threads);
+
+    while (!edges.empty()) {
+        parallelChunks(threads, 0, vertices, [&](unsigned, size_t lo, size_t hi) {
+            for (size_t c = lo; c < hi; ++c) cheapest[c].store(NONE, memory_order_relaxed);
+        });
+
+        parallelChunks(threads, 0, edges.size(), [&](unsigned, size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                int cu = comp[edges[i].u];
+                int cv = comp[edges[i].v];
+                uint64_t rank = edgeRank(edges[i].weight, i);
+                atomicMin(cheapest[cu], rank);
+                atomicMin(cheapest[cv], rank);
+            }
+        });
+
+        parallelChunks(threads, 0, vertices, [&](unsigned t, size_t lo, size_t hi) {
+            for (size_t c = lo; c < hi; ++c) {
+                uint64_t rank = cheapest[c].load(memory_order_relaxed);
+                if (rank == NONE) continue;  // Not a root, or no edge leaves it
+                const Edge& edge = edges[rank & 0xFFFFFFFFu];
+                if (sets.unite(edge.u, edge.v)) picked[t].push_back(edge);
+            }
+        });
+
+        parallelChunks(threads, 0, vertices, [&](unsigned, size_t lo, size_t hi) {
+            for (size_t v = lo; v < hi; ++v) comp[v] = sets.find(static_cast<int>(v));
+        });
+
+        // Each thread compacts its own slice in place, then the slices are moved together
+        size_t n = edges.size();
+        parallelChunks(threads, 0, n, [&](unsigned t, size_t lo, size_t hi) {
+            size_t out = lo;
+            for (size_t i = lo; i < hi; ++i) {
+                if (comp[edges[i].u] != comp[edges[i].v]) edges[out++] = edges[i];
+            }
+            kept[t] = out - lo;
+        });
+        size_t total = 0;
+        for (unsigned t = 0; t < threads; ++t) {
+            size_t lo = n * t / threads;
+            move(edges.begin() + lo, edges.begin() + lo + kept[t], edges.begin() + total);
+            total += kept[t];
+        }
+        edges.resize(total);
+    }
+
+    vector<Edge> forest;
+    for (auto& part : picked) forest.insert(forest.end(), part.begin(), part.end());
+    return forest;
+}
+
+// True when no other spanning tree of vertex A's component has the same weight as tree (the
+// forest's edges in that component), so every MST engine, Prim included, must print it. That fails
+// exactly when some other edge weighs as much as the heaviest tree edge on the path between its
+// ends; path maxima come from binary lifting over the tree rooted at A, the edges are checked in
+// parallel.
+bool treeIsUnique(int vertices, const vector<Edge>& tree, const vector<Edge>& edges, const vector<int>& comp,
+                  unsigned threads) {
+    vector<Edge> arcs;
+    arcs.reserve(2 * tree.size());
+    for (const Edge& edge : tree) {
+        arcs.push_back(edge);
+        arcs.push_back({edge.v, edge.u, edge.weight});
+    }
+    AdjacencyGraph graph;
+    graph.build(vertices, arcs);
+
+    // Breadth first from A for parents, parent edge weights and depths
+    vector<int> parent(vertices, -1), up_weight(vertices, INT_MIN), depth(vertices, -1);
+    vector<int> queue(1, 0);
+    depth[0] = 0;
+    parent[0] = 0;
+    int max_depth = 0;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int u = queue[head];
+        for (int e = graph.offset[u]; e < graph.offset[u + 1]; ++e) {
+            int v = graph.target[e];
+            if (depth[v] >= 0) continue;
+            depth[v] = depth[u] + 1;
+            max_depth = max(max_depth, depth[v]);
+            parent[v] = u;
+            up_weight[v] = graph.weight[e];
+            queue.push_back(v);
+        }
+    }
+
+    // up[k][v] is v's 2^k-th ancestor and heaviest[k][v] the heaviest edge on the way there
+    int levels = 1;
+    while ((1 << levels) <= max_depth) ++levels;
+    vector<vector<int>> up(levels), heaviest(levels);
+    up[0] = parent;
+    heaviest[0] = up_weight;
+    for (int k = 1; k < levels; ++k) {
+        up[k].resize(vertices);
+        heaviest[k].resize(vertices);
+        parallelChunks(threads, 0, vertices, [&](unsigned, size_t lo, size_t hi) {
+            for (size_t v = lo; v < hi; ++v) {
+                int mid = up[k - 1][v];
+                if (mid < 0) continue;
+                up[k][v] = up[k - 1][mid];
+                heaviest[k][v] = max(heaviest[k - 1][v], heaviest[k - 1][mid]);
+            }
+        });
+    }
+
+    auto pathMax = [&](int a, int b) {
+        int heaviest_seen = INT_MIN;
+        if (depth[a] < depth[b]) swap(a, b);
+        for (int k = levels - 1; k >= 0; --k) {
+            if (depth[a] - (1 << k) >= depth[b]) {
+                heaviest_seen = max(heaviest_seen, heaviest[k][a]);
+                a = up[k][a];
+            }
+        }
+        if (a == b) return heaviest_seen;
+        for (int k = levels - 1; k >= 0; --k) {
+            if (up[k][a] != up[k][b]) {
+                heaviest_seen = max({heaviest_seen, heaviest[k][a], heaviest[k][b]});
+                a = up[k][a];
+                b = up[k][b];
+            }
+        }
+        return max({heaviest_seen, heaviest[0][a], heaviest[0][b]});
+    };
+
+    // Only an edge whose weight some tree edge also has can tie, a bitmap of hashed tree weights
+    // turns most of the others away before the path walk
+    size_t bits = 64;
+    while (bits < 16 * tree.size()) bits *= 2;
+    vector<uint64_t> tree_weights(bits / 64);
+    auto weightBit = [&](int weight) { return (static_cast<uint32_t>(weight) * 2654435761u) & (bits - 1); };
+    for (const Edge& edge : tree) {
+        size_t bit = weightBit(edge.weight);
+        tree_weights[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+
+    atomic<bool> tied(false);
+    int root = comp[0];
+    parallelChunks(threads, 0, edges.size(), [&](unsigned, size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi && !tied.load(memory_order_relaxed); ++i) {
+            const Edge& edge = edges[i];
+            size_t bit = weightBit(edge.weight);
+            if (!(tree_weights[bit / 64] >> (bit % 64) & 1)) continue;
+            if (comp[edge.u] != root || edge.u == edge.v) continue;
+            // A parallel copy of a tree edge swaps in the same pair of vertices
+            if (parent[edge.u] == edge.v || parent[edge.v] == edge.u) continue;
+            if (pathMax(edge.u, edge.v) == edge.weight) tied.store(true, memory_order_relaxed);
+        }
+    });
+    return !tied.load();
+}
+
+// The undirected edges of a set of arcs, each once
+vector<Edge> undirectedEdges(const vector<Edge>& arcs) {
+    vector<Edge> edges;
+    edges.reserve(arcs.size() / 2);
+    for (const Edge& arc : arcs) {
+        if (arc.u < arc.v) edges.push_back(arc);
+    }
+    return edges;
+}
+
+// Parallel Borůvka, printing the same tree as the Prim engines. Only vertex A's component is
+// reported, and when ties leave a choice of trees the heap engine picks the one Prim would.
+long long boruvkaMST(int vertices, const vector<Edge>& arcs, unsigned threads) {
+    vector<Edge> edges = undirectedEdges(arcs);
+    vector<int> comp;
+    vector<Edge> forest = boruvkaForest(vertices, edges, threads, comp);
+
+    vector<Edge> tree;
+    long long total_weight = 0;
+    vector<pair<int, int>> mst_edges;
+    if (vertices > 0) {
+        for (const Edge& edge : forest) {
+            if (comp[edge.u] != comp[0]) continue;
+            tree.push_back(edge);
+            total_weight += edge.weight;
+            mst_edges.push_back({min(edge.u, edge.v), max(edge.u, edge.v)});
+        }
+    }
+    if (vertices > 0 && !treeIsUnique(vertices, tree, edges, comp, threads)) {
+        AdjacencyGraph graph;
+        graph.build(vertices, arcs);
+        return heapPrimMST(graph);
+    }
+    printMST(total_weight, mst_edges);
+    return total_weight;
+}
+
+// Strong scaling of boruvkaForest on this graph: the same work on 1, 2, 4, ... threads up to
+// max_threads, best of three runs each, with the speedup over one thread
+void reportScaling(int vertices, const vector<Edge>& arcs, unsigned max_threads) {
+    vector<Edge> edges = undirectedEdges(arcs);
+    vector<int> comp;
+    double single_ms = 0;
+    fprintf(stderr, "boruvka on %d vertices, %zu edges\n", vertices, edges.size());
+    for (unsigned threads = 1;; threads = min(threads * 2, max_threads)) {
+        double best_ms = 0;
+        for (int run = 0; run < 3; ++run) {
+            auto start = chrono::steady_clock::now();
+            boruvkaForest(vertices, edges, threads, comp);
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            if (run == 0 || ms < best_ms) best_ms = ms;
+        }
+        if (threads == 1) single_ms = best_ms;
+        fprintf(stderr, "  %2u threads: %9.2f ms  speedup %.2fx\n", threads, best_ms, single_ms / best_ms);
+        if (threads >= max_threads) break;
+    }
+}
+
+// Picks the engine for an edge list with the given number of arcs when none was forced
+MstEngine chooseEngine(const MstOptions& options, int vertices, size_t arcs) {
+    if (options.engine != MstEngine::Auto) return options.engine;
+    double possible = static_cast<double>(vertices) * vertices;
+    if (possible > 0 && arcs >= DENSE_FRACTION * possible) return MstEngine::Dense;
+    return (options.threads > 1 && arcs >= BORUVKA_MIN_ARCS) ? MstEngine::Boruvka : MstEngine::Heap;
+}
+
+// Runs the chosen engine on a graph given as its arcs
+void solveArcs(int vertices, const vector<Edge>& arcs, MstEngine engine, const MstOptions& options) {
+    if (engine == MstEngine::Kruskal) {
+        kruskalMST(vertices, arcs);
+    } else if (engine == MstEngine::Boruvka && arcs.size() < BORUVKA_MAX_ARCS) {
+        if (options.scaling) reportScaling(vertices, arcs, options.threads);
+        boruvkaMST(vertices, arcs, options.threads);
+    } else if (engine == MstEngine::Dense && none_of(arcs.begin(), arcs.end(), [](const Edge& arc) { return arc.weight == -1; })) {
+        vector<int> matrix(static_cast<size_t>(vertices) * vertices, -1);
+        for (const Edge& arc : arcs) {
+            // Keep the lightest of repeated edges, as the heap engine does
+            int& slot = matrix[static_cast<size_t>(arc.u) * vertices + arc.v];
+            if (slot == -1 || arc.weight < slot) slot = arc.weight;
+        }
+        primMST(vertices, matrix);
+    } else {
+        // Also the dense engine's stand-in when an edge weighs -1, which its matrix would read as
+        // no edge, and Boruvka's past BORUVKA_MAX_ARCS; the heap engine prints the same tree
+        AdjacencyGraph graph;
+        graph.build(vertices, arcs);
+        heapPrimMST(graph);
+    }
+}
+
+// Reads "V E" and E edges, false at end of input or (with a message) on a negative count
+bool readEdgeList(int& vertices, vector<Edge>& arcs) {
+    long long edge_count;
+    if (!input.readInt(vertices) || !input.readInt(edge_count)) return false;
+    if (vertices < 0 || edge_count < 0) {
+        fprintf(stderr, "bad edge list header \"%d %lld\"\n", vertices, edge_count);
+        return false;
+    }
+    arcs.clear();
+    arcs.reserve(2 * min(edge_count, EDGE_RESERVE_LIMIT));  // The count is only a claim until the edges arrive
+    for (long long i = 0; i < edge_count; ++i) {
+        Edge edge;
+        if (!input.readInt(edge.u) || !input.readInt(edge.v) || !input.readInt(edge.weight)) break;
+        if (edge.u < 0 || edge.u >= vertices || edge.v < 0 || edge.v >= vertices) continue;  // Not a vertex
+        arcs.push_back(edge);
+        arcs.push_back({edge.v, edge.u, edge.weight});
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool edge_list = false;
+    MstOptions options;
+    for (int a = 1; a < argc; ++a) {
+        if (strcmp(argv[a], "--edges") == 0) {
+            edge_list = true;
+        } else if (strcmp(argv[a], "--engine") == 0 && a + 1 < argc) {
+            ++a;
+            if (strcmp(argv[a], "dense") == 0) options.engine = MstEngine::Dense;
+            else if (strcmp(argv[a], "heap") == 0) options.engine = MstEngine::Heap;
+            else if (strcmp(argv[a], "kruskal") == 0) options.engine = MstEngine::Kruskal;
+            else if (strcmp(argv[a], "boruvka") == 0) options.engine = MstEngine::Boruvka;
+        } else if (strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+            if (!parseThreadCount(argv[++a], options.threads)) return 1;
+        } else if (strcmp(argv[a], "--scaling") == 0) {
+            options.scaling = true;
+        } else if (strcmp(argv[a], "--numeric") == 0) {
+            numeric_names = true;
+        }
+    }
+
     int vertices;
     bool first_case = true;
+    vector<Edge> arcs;
 
-    while (cin >> vertices) {
+    while (edge_list ? readEdgeList(vertices, arcs) : input.readInt(vertices)) {
         if (!first_case) {
-            cout << endl;  // Blank line between different graphs via the requested output
+            output.writeChar('\n');  // Blank line between different graphs via the requested output
         }
         first_case = false;
 
-        // Read the distance matrix
-        vector<vector<int>> matrix(vertices, vector<int>(vertices));
+        if (edge_list) {
+            solveArcs(vertices, arcs, chooseEngine(options, vertices, arcs.size()), options);
+            continue;
+        }
+
+        // Read the distance matrix into one row-major buffer
+        vector<int> matrix(static_cast<size_t>(vertices) * vertices);
+        for (int& cell : matrix) {
+            input.readInt(cell);
+        }
+
+        if (options.engine == MstEngine::Auto || options.engine == MstEngine::Dense) {
+            // Run Prim's algorithm to compute the Minimum Spanning Tree
+            primMST(vertices, matrix);
+            continue;
+        }
+        arcs.clear();
         for (int i = 0; i < vertices; ++i) {
+            const int* row = matrix.data() + static_cast<size_t>(i) * vertices;
             for (int j = 0; j < vertices; ++j) {
-                cin >> matrix[i][j];
+                if (row[j] != -1) arcs.push_back({i, j, row[j]});
             }
         }
-
-        // Run Prim's algorithm to compute the Minimum Spanning Tree
-        primMST(vertices, matrix);
+        solveArcs(vertices, arcs, options.engine, options);
     }
 
     return 0;
 }
-
@@ -1,16 +1,37 @@
 //Jonathan Attanasio
 //This program is supposed to parse through a DNA sequence and find repeated substring within the input.
 //Used push_back for input of the sequencing, also made sure the output lines up with desired format.
-#include <iostream>
+//The windows are packed two bits per base into an integer that is rolled one base at a time, so no substring
+//is ever allocated, and counted in a pair of bitmaps indexed directly by that integer (or, for long windows,
+//an open addressing table). Windows with anything but A, C, G or T in them fall back to the string map.
+//--k N sets the window length (9 by default, up to 32). Input is streamed through one buffer and each sequence
+//is reported as soon as it ends, so memory follows the distinct windows of one sequence rather than its length:
+//sequences far larger than memory work when k is at most 9 and they only hold A, C, G and T. Longer windows need
+//table space per distinct window, and so does every distinct window with another letter in it, since those are
+//kept as strings. --threads N counts long sequences on N threads (0 picks one per core, build with -pthread).
+//--maximal instead lists every maximal repeat of at least k bases with its occurrence count, found through a
+//suffix array and its LCP array. --reference runs the original version.
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <unordered_map>
 #include <set>
 #include <vector>
 #include <string>
+#include <thread>
+#include "fastio.h"
+#include "threads.h"
+
+// Buffered stdout shared by every call of findRepeatedSequences
+FastOutput output;
 
 //This function is the entire program essentially, it takes in the sequence and finds all 9-letter substrings
 //then finds the dupes, and formats the output (lexicographically) in sequence.
-void findRepeatedSequences(const std::string &dna) {
-    const int SEQ_LENGTH = 9;
+void findRepeatedSequences(const std::string &dna, const int SEQ_LENGTH = 9) {
     std::unordered_map<std::string, int> sequenceCount;
     std::set<std::string> repeats;
 
@@ -29,24 +50,645 @@ void findRepeatedSequences(const std::string &dna) {
 
     // Output each repeated sequence
     for (const auto &seq : repeats) {
-        std::cout << seq << std::endl;
+        output.writeString(seq);
+        output.writeChar('\n');
+    }
+    // Output -1 after each DNA sequence
+    output.writeString("-1\n");
+}
+
+// Two bits per base. The codes follow the alphabet, so packed keys sort exactly like the strings
+// they encode.
+struct BaseCodes {
+    int8_t code[256];
+    BaseCodes() {
+        std::memset(code, -1, sizeof(code));
+        code['A'] = 0;
+        code['C'] = 1;
+        code['G'] = 2;
+        code['T'] = 3;
+    }
+};
+const BaseCodes BASES;
+const char BASE_LETTERS[4] = {'A', 'C', 'G', 'T'};
+
+// Bytes read from stdin at a time by the streaming scanner, per thread
+const size_t STREAM_BUFFER = 1 << 20;
+
+// Longest window counted in bitmaps, 4^12 bits is 2MiB per map
+const int BITMAP_MAX_K = 12;
+
+// Stretches of one sequence shorter than this per thread are counted on a single thread
+const size_t PARALLEL_MIN_BASES = 1 << 16;
+
+// Longest sequence --maximal takes: suffix array positions are ints and need room for the
+// sentinel and one past it
+const size_t MAXIMAL_MAX_BASES = INT_MAX - 2;
+
+// Counts packed k-mers up to "more than once" in two bitmaps of 4^k bits each (32KiB apiece for
+// k = 9, so both stay in L1/L2). A key is added to repeats the moment its second copy shows up.
+// Partitions are ranges of bitmap words, which are also ranges of key prefixes.
+class KmerBitmap {
+public:
+    KmerBitmap(int k, size_t) : seen(words(k)), repeated(words(k)), overflow(false) {}
+
+    void add(uint64_t key) {
+        uint64_t bit = uint64_t(1) << (key & 63);
+        uint64_t& word = seen[key >> 6];
+        if (!(word & bit)) {
+            word |= bit;
+            if (touched.size() < seen.size()) {
+                touched.push_back(key);
+            } else {
+                overflow = true;
+            }
+        } else if (!(repeated[key >> 6] & bit)) {
+            repeated[key >> 6] |= bit;
+            repeats.push_back(key);
+        }
+    }
+
+    // Appends the repeated keys of the current sequence in ascending (so lexicographic) order and
+    // forgets every key. Short sequences unmark just the keys they set, long ones wipe the maps.
+    void takeRepeats(std::vector<uint64_t>& out) {
+        std::sort(repeats.begin(), repeats.end());
+        out.insert(out.end(), repeats.begin(), repeats.end());
+        if (overflow) {
+            std::fill(seen.begin(), seen.end(), 0);
+            std::fill(repeated.begin(), repeated.end(), 0);
+        } else {
+            for (uint64_t key : touched) {
+                seen[key >> 6] = 0;
+                repeated[key >> 6] = 0;
+            }
+        }
+        forgetLists();
+    }
+
+    // Appends, in order, the keys of partition p that were repeated within one worker's table or
+    // seen by two of them, and clears that partition in every table
+    static void mergePartition(std::vector<KmerBitmap>& tables, size_t p, size_t partitions,
+                               std::vector<uint64_t>& out) {
+        size_t count = tables[0].seen.size();
+        size_t first = count * p / partitions;
+        size_t last = count * (p + 1) / partitions;
+        for (size_t w = first; w < last; ++w) {
+            uint64_t once = 0;
+            uint64_t twice = 0;
+            for (KmerBitmap& table : tables) {
+                twice |= table.repeated[w] | (once & table.seen[w]);
+                once |= table.seen[w];
+                table.seen[w] = 0;
+                table.repeated[w] = 0;
+            }
+            while (twice != 0) {
+                out.push_back(w * 64 + __builtin_ctzll(twice));
+                twice &= twice - 1;
+            }
+        }
+    }
+
+    // Drops the per-sequence lists once mergePartition has cleared the maps themselves
+    void forgetLists() {
+        touched.clear();
+        repeats.clear();
+        overflow = false;
+    }
+
+private:
+    static size_t words(int k) { return ((size_t(1) << (2 * k)) + 63) / 64; }
+
+    std::vector<uint64_t> seen;
+    std::vector<uint64_t> repeated;
+    std::vector<uint64_t> repeats;
+    std::vector<uint64_t> touched;  // Keys first seen this sequence, while there are fewer than words
+    bool overflow;                  // More keys than that, clearing wipes everything
+};
+
+// Counts packed k-mers that are too long for a bitmap: linear probing over a power of two capacity
+// that is kept at most half full, with a count per slot that stops at 2
+class KmerHashTable {
+public:
+    KmerHashTable() { reset(MIN_CAPACITY); }
+
+    void add(uint64_t key) { addCount(key, 1); }
+
+    // Adds count copies of key
+    void addCount(uint64_t key, uint8_t copies) {
+        size_t slot = (key * 0x9E3779B97F4A7C15ull) >> shift;
+        while (count[slot] != 0) {
+            if (keys[slot] == key) {
+                if (count[slot] == 1) {
+                    count[slot] = 2;
+                    repeats.push_back(key);
+                }
+                return;
+            }
+            slot = (slot + 1) & (keys.size() - 1);
+        }
+        keys[slot] = key;
+        count[slot] = copies > 1 ? 2 : 1;
+        if (copies > 1) repeats.push_back(key);
+        if (++used * 2 > keys.size()) grow();
+    }
+
+    // Calls visit(key, count) for every key in the table
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (count[i] != 0) visit(keys[i], count[i]);
+        }
+    }
+
+    bool empty() const { return used == 0; }
+    size_t size() const { return used; }
+
+    // Makes room for keys without growing, only valid while the table is empty
+    void reserve(size_t keys_expected) {
+        size_t capacity = MIN_CAPACITY;
+        while (capacity < 2 * keys_expected) capacity *= 2;
+        if (capacity > keys.size()) reset(capacity);
+    }
+
+    // Appends the repeated keys in ascending (so lexicographic) order and forgets every key, giving
+    // the memory back when a big sequence left the table far too large
+    void takeRepeats(std::vector<uint64_t>& out) {
+        std::sort(repeats.begin(), repeats.end());
+        out.insert(out.end(), repeats.begin(), repeats.end());
+        if (keys.size() > 4 * std::max(2 * used, MIN_CAPACITY)) {
+            reset(MIN_CAPACITY);
+        } else {
+            std::fill(count.begin(), count.end(), 0);
+            used = 0;
+        }
+        repeats.clear();
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 1 << 12;
+
+    void reset(size_t capacity) {
+        keys.assign(capacity, 0);
+        count.assign(capacity, 0);
+        used = 0;
+        shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1) --shift;
+    }
+
+    void grow() {
+        std::vector<uint64_t> old_keys;
+        std::vector<uint8_t> old_count;
+        old_keys.swap(keys);
+        old_count.swap(count);
+        reset(old_keys.size() * 2);
+        for (size_t i = 0; i < old_keys.size(); ++i) {
+            if (old_count[i] == 0) continue;
+            size_t slot = (old_keys[i] * 0x9E3779B97F4A7C15ull) >> shift;
+            while (count[slot] != 0) slot = (slot + 1) & (keys.size() - 1);
+            keys[slot] = old_keys[i];
+            count[slot] = old_count[i];
+            ++used;
+        }
+    }
+
+    std::vector<uint64_t> keys;
+    std::vector<uint8_t> count;  // 0 for an empty slot, else 1 or 2 (seen more than once)
+    std::vector<uint64_t> repeats;
+    size_t used;
+    int shift;                   // 64 - log2(capacity), for multiplicative hashing
+};
+
+// One hash table per key prefix, so that after a parallel count the tables for one prefix can be
+// merged by one thread without locks, and the merged prefixes come out already in key order
+class PartitionedHashTable {
+public:
+    PartitionedHashTable(int k, size_t partitions) : parts(partitions), shift(2 * k) {
+        for (size_t p = partitions; p > 1; p >>= 1) --shift;
+    }
+
+    void add(uint64_t key) { parts[parts.size() == 1 ? 0 : key >> shift].add(key); }
+
+    void takeRepeats(std::vector<uint64_t>& out) {
+        for (KmerHashTable& part : parts) part.takeRepeats(out);
+    }
+
+    // Appends, in order, the repeated keys with prefix p over all tables and clears that prefix
+    static void mergePartition(std::vector<PartitionedHashTable>& tables, size_t p, size_t,
+                               std::vector<uint64_t>& out) {
+        // Sized up front: the parts are walked in slot order, which is hash order, and feeding keys in
+        // hash order into a smaller table than they came from piles them all into one probe run
+        KmerHashTable merged;
+        size_t total = 0;
+        for (PartitionedHashTable& table : tables) total += table.parts[p].size();
+        merged.reserve(total);
+        for (PartitionedHashTable& table : tables) {
+            KmerHashTable& part = table.parts[p];
+            if (part.empty()) continue;
+            part.forEach([&](uint64_t key, uint8_t count) { merged.addCount(key, count); });
+            std::vector<uint64_t> ignored;
+            part.takeRepeats(ignored);
+        }
+        merged.takeRepeats(out);
+    }
+
+    void forgetLists() {}
+
+private:
+    std::vector<KmerHashTable> parts;
+    int shift;  // Key bits below the prefix
+};
+
+// Unpacks a key back into its k letters
+void decodeKmer(uint64_t key, int k, char* letters) {
+    for (int i = k - 1; i >= 0; --i) {
+        letters[i] = BASE_LETTERS[key & 3];
+        key >>= 2;
+    }
+}
+
+// Prints one sequence's repeats in the same format as findRepeatedSequences: the sorted packed repeats
+// and the repeats of windows that were not pure A/C/G/T, merged in lexicographic order
+void reportRepeats(const std::vector<uint64_t>& repeats, const std::unordered_map<std::string, int>& otherCount,
+                   int k) {
+    std::vector<std::string> otherRepeats;
+    for (const auto& entry : otherCount) {
+        if (entry.second > 1) otherRepeats.push_back(entry.first);
+    }
+    std::sort(otherRepeats.begin(), otherRepeats.end());
+
+    size_t other = 0;
+    char letters[32];
+    for (uint64_t key : repeats) {
+        decodeKmer(key, k, letters);
+        while (other < otherRepeats.size() && otherRepeats[other].compare(0, k, letters, k) < 0) {
+            output.writeString(otherRepeats[other++]);
+            output.writeChar('\n');
+        }
+        output.writeString(letters, k);
+        output.writeChar('\n');
+    }
+    for (; other < otherRepeats.size(); ++other) {
+        output.writeString(otherRepeats[other]);
+        output.writeChar('\n');
     }
     // Output -1 after each DNA sequence
-    std::cout << "-1" << std::endl;
+    output.writeString("-1\n");
+}
+
+// Counts the windows ending at positions [lo, hi) of data, all inside one sequence, into table
+// (and otherCount for windows that are not pure A/C/G/T). The k - 1 bytes before lo must be
+// readable: the key is first rolled over them, so chunks can start anywhere.
+template <typename Table>
+void countWindows(const char* data, size_t lo, size_t hi, int k, Table& table,
+                  std::unordered_map<std::string, int>& otherCount) {
+    const size_t window = static_cast<size_t>(k);
+    const uint64_t mask = (k == 32) ? ~uint64_t(0) : (uint64_t(1) << (2 * k)) - 1;
+    uint64_t key = 0;
+    size_t valid_run = 0;  // Consecutive A/C/G/T bases ending at the current one
+    size_t length = 0;     // Consecutive bases of this sequence ending at the current one
+    for (size_t p = lo - (window - 1); p < hi; ++p) {
+        unsigned char c = static_cast<unsigned char>(data[p]);
+        if (FastInput::isSpace(data[p])) {
+            length = 0;
+            valid_run = 0;
+            continue;
+        }
+        ++length;
+        int code = BASES.code[c];
+        if (code < 0) {
+            valid_run = 0;
+        } else {
+            key = ((key << 2) | static_cast<uint64_t>(code)) & mask;
+            ++valid_run;
+        }
+        if (p < lo || length < window) continue;
+        if (valid_run >= window) {
+            table.add(key);
+        } else {
+            otherCount[std::string(data + p + 1 - window, window)]++;
+        }
+    }
+}
+
+// Reads whitespace separated sequences from input one buffer at a time and reports each as soon as
+// it ends, with the same output as findRepeatedSequences on every sequence. The last k - 1 bytes of
+// every buffer are kept in front of the next one, so windows straddling the boundary are rebuilt
+// from them. With several threads each long stretch of a sequence is cut into one chunk per thread,
+// every thread counts into its own partitioned table, and when the sequence ends each partition
+// is merged across the threads by one thread of its own.
+template <typename Table>
+void scanStream(FastInput& input, int k, unsigned threads) {
+    size_t partitions = 1;
+    if (threads > 1) {
+        while (partitions < 4 * threads && partitions * 2 <= (size_t(1) << std::min(2 * k, 20))) partitions *= 2;
+    }
+    std::vector<Table> tables;
+    for (unsigned t = 0; t < threads; ++t) tables.emplace_back(k, partitions);
+    std::vector<std::unordered_map<std::string, int>> otherCounts(threads);
+    std::vector<std::vector<uint64_t>> partRepeats(partitions);
+    std::vector<uint64_t> repeats;
+    bool shared = false;  // Some window of the current sequence was counted outside tables[0]
+
+    auto finishSequence = [&]() {
+        repeats.clear();
+        if (!shared) {
+            tables[0].takeRepeats(repeats);
+        } else {
+            parallelChunks(threads, 0, partitions, [&](unsigned, size_t lo, size_t hi) {
+                for (size_t p = lo; p < hi; ++p) Table::mergePartition(tables, p, partitions, partRepeats[p]);
+            });
+            for (auto& part : partRepeats) {
+                repeats.insert(repeats.end(), part.begin(), part.end());
+                part.clear();
+            }
+            for (Table& table : tables) table.forgetLists();
+            for (unsigned t = 1; t < threads; ++t) {
+                for (const auto& entry : otherCounts[t]) otherCounts[0][entry.first] += entry.second;
+                otherCounts[t].clear();
+            }
+        }
+        reportRepeats(repeats, otherCounts[0], k);
+        otherCounts[0].clear();
+        shared = false;
+    };
+
+    const size_t carry = static_cast<size_t>(k) - 1;
+    const size_t capacity = STREAM_BUFFER * threads;
+    std::vector<char> buffer(carry + capacity, ' ');
+    char* data = buffer.data();
+    bool open = false;  // A sequence is still running at the end of the last buffer
+    while (true) {
+        size_t got = input.readRaw(data + carry, capacity);
+        size_t end = carry + got;
+        size_t p = carry;
+        while (p < end) {
+            if (FastInput::isSpace(data[p])) {
+                if (open) finishSequence();
+                open = false;
+                ++p;
+                continue;
+            }
+            size_t stop = p;
+            while (stop < end && !FastInput::isSpace(data[stop])) ++stop;
+            if (threads > 1 && stop - p >= threads * PARALLEL_MIN_BASES) {
+                parallelChunks(threads, p, stop, [&](unsigned t, size_t lo, size_t hi) {
+                    countWindows(data, lo, hi, k, tables[t], otherCounts[t]);
+                });
+                shared = true;
+            } else {
+                countWindows(data, p, stop, k, tables[0], otherCounts[0]);
+            }
+            open = true;
+            p = stop;
+        }
+        if (got == 0) break;
+        std::memmove(data, data + got, carry);
+    }
+    if (open) finishSequence();
 }
 
-int main() {
+// SA-IS (Nong, Zhang and Chan): sorts all suffixes of text in linear time by sorting the LMS
+// suffixes (an S-type suffix right after an L-type one) and inducing everything else from them,
+// recursing on the LMS substring names when those are not yet unique. Every value of text must be
+// below alphabet and the last one must be a unique smallest sentinel.
+std::vector<int> suffixArrayIS(const std::vector<int>& text, int alphabet) {
+    const int n = static_cast<int>(text.size());
+    std::vector<int> sa(n, -1);
+    if (n == 1) {
+        sa[0] = 0;
+        return sa;
+    }
+
+    std::vector<bool> stype(n);  // Suffix i is smaller than suffix i + 1
+    stype[n - 1] = true;
+    for (int i = n - 2; i >= 0; --i) stype[i] = text[i] < text[i + 1] || (text[i] == text[i + 1] && stype[i + 1]);
+    auto isLms = [&](int i) { return i > 0 && stype[i] && !stype[i - 1]; };
+
+    std::vector<int> bucket_start(alphabet + 1, 0);
+    for (int c : text) bucket_start[c + 1]++;
+    for (int c = 0; c < alphabet; ++c) bucket_start[c + 1] += bucket_start[c];
+    std::vector<int> next(alphabet);
+
+    // Drops the LMS suffixes at the ends of their buckets (in the given order), then induces the
+    // L-type suffixes left to right and the S-type ones right to left
+    auto induce = [&](const std::vector<int>& lms) {
+        std::fill(sa.begin(), sa.end(), -1);
+        for (int c = 0; c < alphabet; ++c) next[c] = bucket_start[c + 1];
+        for (size_t j = lms.size(); j-- > 0;) sa[--next[text[lms[j]]]] = lms[j];
+        for (int c = 0; c < alphabet; ++c) next[c] = bucket_start[c];
+        for (int i = 0; i < n; ++i) {
+            int j = sa[i] - 1;
+            if (sa[i] > 0 && !stype[j]) sa[next[text[j]]++] = j;
+        }
+        for (int c = 0; c < alphabet; ++c) next[c] = bucket_start[c + 1];
+        for (int i = n - 1; i >= 0; --i) {
+            int j = sa[i] - 1;
+            if (sa[i] > 0 && stype[j]) sa[--next[text[j]]] = j;
+        }
+    };
+
+    std::vector<int> lms;
+    for (int i = 1; i < n; ++i) {
+        if (isLms(i)) lms.push_back(i);
+    }
+    induce(lms);
+
+    // Name the LMS substrings in sorted order, equal substrings sharing a name
+    std::vector<int> name(n, -1);
+    int names = 0;
+    int prev = -1;
+    for (int i = 0; i < n; ++i) {
+        int cur = sa[i];
+        if (!isLms(cur)) continue;
+        bool same = prev >= 0;
+        for (int d = 0; same; ++d) {
+            if (text[prev + d] != text[cur + d] || stype[prev + d] != stype[cur + d]) {
+                same = false;
+            } else if (d > 0 && (isLms(prev + d) || isLms(cur + d))) {
+                same = isLms(prev + d) && isLms(cur + d);
+                break;
+            }
+        }
+        if (!same) ++names;
+        name[cur] = names - 1;
+        prev = cur;
+    }
+
+    std::vector<int> sorted_lms(lms.size());
+    if (names < static_cast<int>(lms.size())) {
+        std::vector<int> reduced(lms.size());
+        for (size_t j = 0; j < lms.size(); ++j) reduced[j] = name[lms[j]];
+        std::vector<int> reduced_sa = suffixArrayIS(reduced, names);
+        for (size_t j = 0; j < lms.size(); ++j) sorted_lms[j] = lms[reduced_sa[j]];
+    } else {
+        for (int i : lms) sorted_lms[name[i]] = i;
+    }
+    induce(sorted_lms);
+    return sa;
+}
+
+// Kasai's algorithm in its Phi form: lcp[i] is the length of the common prefix of suffixes
+// sa[i - 1] and sa[i]. Walking the suffixes in text order through phi (the suffix sorted just
+// before each one) keeps the comparisons sequential, and the bytes of dna are compared directly.
+// The sentinel suffix (sa[0]) has an LCP of 0.
+std::vector<int> longestCommonPrefixes(const std::string& dna, const std::vector<int>& sa) {
+    const int n = static_cast<int>(sa.size());
+    const int length = n - 1;
+    std::vector<int> plcp(n);  // phi first, then overwritten in place by the LCP in text order
+    plcp[sa[0]] = -1;
+    for (int i = 1; i < n; ++i) plcp[sa[i]] = sa[i - 1];
+    int h = 0;
+    for (int i = 0; i < n; ++i) {
+        int j = plcp[i];
+        if (j < 0) {
+            h = 0;
+        } else {
+            while (i + h < length && j + h < length && dna[i + h] == dna[j + h]) ++h;
+        }
+        plcp[i] = h;
+        if (h > 0) --h;
+    }
+    std::vector<int> lcp(n);
+    for (int i = 0; i < n; ++i) lcp[i] = plcp[sa[i]];
+    return lcp;
+}
+
+// Prints every maximal repeat of dna at least minLength bases long (a substring occurring twice or
+// more that cannot be extended on either side without losing an occurrence) with its number of
+// occurrences, in lexicographic order, followed by -1. The longest repeated substrings are among
+// them. The suffix array and its LCP array make this linear in the length of dna: each LCP interval
+// is a right-maximal repeat, and it is left-maximal when the bases before its suffixes differ.
+// Unlike the k-mer scan this needs the whole sequence in memory: about 22 bytes per base at peak
+// (the text, suffix array and LCP arrays as ints, the SA-IS recursion on at most half the length)
+// plus 12 per reported repeat, against the fixed 64KiB of the k <= 12 bitmaps or the hash table's
+// 40 to 50 bytes per distinct k-mer for longer k. Sequences past MAXIMAL_MAX_BASES print a
+// message on stderr and return false.
+bool findMaximalRepeats(const std::string& dna, int minLength) {
+    if (dna.size() > MAXIMAL_MAX_BASES) {
+        std::fprintf(stderr, "--maximal takes sequences of up to %zu bases, got %zu\n", MAXIMAL_MAX_BASES,
+                     dna.size());
+        return false;
+    }
+    const int n = static_cast<int>(dna.size()) + 1;
+    std::vector<int> text(n);
+    for (int i = 0; i + 1 < n; ++i) text[i] = static_cast<unsigned char>(dna[i]) + 1;
+    text[n - 1] = 0;  // Sentinel
+    std::vector<int> sa = suffixArrayIS(text, 257);
+    std::vector<int>().swap(text);
+    std::vector<int> lcp = longestCommonPrefixes(dna, sa);
+
+    // changes[i]: how many neighbours in sa[0..i] differ in the base before them; suffix 0 has
+    // none, which differs from everything
+    std::vector<int> changes(n);
+    int prev_before = -1;
+    for (int i = 0; i < n; ++i) {
+        int before = sa[i] == 0 ? -1 : static_cast<unsigned char>(dna[sa[i] - 1]);
+        changes[i] = (i == 0) ? 0 : changes[i - 1] + (before != prev_before || before < 0);
+        prev_before = before;
+    }
+
+    // Walk the LCP intervals bottom up with a stack of (lcp, left bound)
+    struct Interval {
+        int lcp, lb, rb;
+    };
+    std::vector<Interval> stack(1, {0, 0, 0});
+    std::vector<Interval> found;
+    for (int i = 1; i <= n; ++i) {
+        int cur = (i < n) ? lcp[i] : 0;
+        int lb = i - 1;
+        while (cur < stack.back().lcp) {
+            Interval top = stack.back();
+            stack.pop_back();
+            top.rb = i - 1;
+            if (top.lcp >= minLength && changes[top.rb] - changes[top.lb] > 0) found.push_back(top);
+            lb = top.lb;
+        }
+        if (cur > stack.back().lcp) stack.push_back({cur, lb, 0});
+    }
+    std::vector<int>().swap(lcp);
+    std::vector<int>().swap(changes);
+
+    // Intervals come out children first. Sorting by (left bound, length) puts each repeat after its
+    // prefixes and disjoint ones in suffix order, which is lexicographic order; a counting sort on the
+    // left bound keeps it linear, and within one left bound the order only has to be reversed.
+    std::vector<int> start(n + 1, 0);
+    for (const Interval& interval : found) start[interval.lb + 1]++;
+    for (int i = 0; i < n; ++i) start[i + 1] += start[i];
+    std::vector<Interval> ordered(found.size());
+    for (size_t j = found.size(); j-- > 0;) ordered[start[found[j].lb]++] = found[j];
+
+    for (const Interval& interval : ordered) {
+        output.writeString(dna.data() + sa[interval.lb], interval.lcp);
+        output.writeChar(' ');
+        output.writeInt(interval.rb - interval.lb + 1);
+        output.writeChar('\n');
+    }
+    output.writeString("-1\n");
+    return true;
+}
+
+// Reads the value of --k, false (with a message on stderr) when it is not a number from 1 to 32
+bool parseWindowLength(const char* text, int& k) {
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE) {
+        std::fprintf(stderr, "--k needs a number, got '%s'\n", text);
+        return false;
+    }
+    if (parsed < 1 || parsed > 32) {
+        std::fprintf(stderr, "--k must be between 1 and 32, got %ld\n", parsed);
+        return false;
+    }
+    k = static_cast<int>(parsed);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool reference = false;
+    bool maximal = false;
+    int k = 9;
+    unsigned threads = 1;
+    for (int a = 1; a < argc; ++a) {
+        if (std::strcmp(argv[a], "--reference") == 0) {
+            reference = true;
+        } else if (std::strcmp(argv[a], "--maximal") == 0) {
+            maximal = true;
+        } else if (std::strcmp(argv[a], "--k") == 0 && a + 1 < argc) {
+            if (!parseWindowLength(argv[++a], k)) return 1;
+        } else if (std::strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+            if (!parseThreadCount(argv[++a], threads)) return 1;
+        }
+    }
+    FastInput input;
+    if (maximal) {
+        // One sequence in memory at a time, the suffix array needs all of it
+        std::string dna;
+        while (input.readToken(dna)) {
+            if (!findMaximalRepeats(dna, k)) return 1;
+        }
+        return 0;
+    }
+    if (!reference) {
+        if (k <= BITMAP_MAX_K) {
+            scanStream<KmerBitmap>(input, k, threads);
+        } else {
+            scanStream<PartitionedHashTable>(input, k, threads);
+        }
+        return 0;
+    }
+
     std::vector<std::string> dnaSequences;
     std::string dna;
 
     // Read all DNA sequences from standard input
-    while (std::cin >> dna) {
+    while (input.readToken(dna)) {
         dnaSequences.push_back(dna);
     }
 
     // Process each DNA sequence
     for (const auto &dna : dnaSequences) {
-        findRepeatedSequences(dna);
+        findRepeatedSequences(dna, k);
     }
 
     return 0;
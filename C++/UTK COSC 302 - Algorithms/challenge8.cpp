@@ -2,11 +2,69 @@
 //This program is a dynamic one that is being used to take two strings similar to DNA
 //sequences and determine the best way to match, mismatch, or miss the alignment. The total
 //score comes from the diagonal like nature of the table.
+//The score only ever needs the previous row of the table, so it is computed in one row as long as the shorter
+//sequence. --align also prints the alignment itself (two lines, '-' for gaps), recovered in linear space with
+//Hirschberg's divide and conquer. --band W only fills the cells within W of the diagonal (widened by the length
+//difference), which is exact whenever an optimal alignment stays that close and otherwise a lower bound; with
+//--align the band is traced back directly. The plain score is filled one anti-diagonal at a time in 16-bit
+//(or, for very long sequences, 32-bit) SSE2/AVX2 lanes, picked at run time; --scalar uses the row instead.
+//--batch scores a whole stream of pairs instead (consecutive lines or FASTA records taken two at a time), and
+//--one-vs-many scores the first sequence against each later one; both print one score per pair in input order,
+//spread the pairs over --threads N threads (0 picks one per core, build with -pthread) and report GCUPS on stderr
+//with --stats. --reference fills the whole table like the original version.
+//Scoring other than the fixed global one goes through a row engine templated on the scoring policies:
+//--matrix FILE reads a BLOSUM/PAM style substitution table, --gap G sets the score of each gap character and
+//--gap-open O makes gaps affine (a gap of length L scores O + L * G, Gotoh's three-state recurrence), while
+//--local (Smith-Waterman) and --semi-global (end gaps free) change what is aligned. These work for single pairs
+//and batches; --align, --band and the vector kernel stay with the default scoring. Gap and table scores must be
+//within +-2^24, and pairs long enough for their scores to come near the int limits get 64-bit cells.
 
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include "fastio.h"
+#include "threads.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define ALIGN_HAVE_AVX2 1
+#endif
+
+// Buffered stdin/stdout
+FastInput input;
+FastOutput output;
+
+const int MATCH = 1;
+const int MISMATCH = -1;
+const int GAP = -1;
+
+// Score of a cell outside the band, low enough that a few gaps added to it never wrap
+const int NEG_INF = INT_MIN / 4;
+
+// Largest magnitude accepted for a gap or substitution score. Scores this size keep any pair's
+// cells far inside 64 bits, and real tables are a few orders of magnitude below it.
+const int SCORE_LIMIT = 1 << 24;
+
+// Hirschberg stops splitting once a piece fits in this many traceback cells
+const long long HIRSCHBERG_BASE_CELLS = 1 << 16;
 
 // Function to perform global alignment using dynamic programming
 int global_alignment(const std::string& S1, const std::string& S2) {
@@ -16,7 +74,7 @@ int global_alignment(const std::string& S1, const std::string& S2) {
     // Initialize table with zeroes
     std::vector<std::vector<int>> F(m + 1, std::vector<int>(n + 1, 0));
 
-    // Base cases 
+    // Base cases
     for (int i = 1; i <= m; ++i) {
         F[i][0] = F[i - 1][0] - 1;  // Gaps in S2 (deleting all from S1)
     }
@@ -28,7 +86,7 @@ int global_alignment(const std::string& S1, const std::string& S2) {
     for (int i = 1; i <= m; ++i) {
         for (int j = 1; j <= n; ++j) {
             int match = (S1[i - 1] == S2[j - 1]) ? 1 : -1; // Match or mismatch score
-            F[i][j] = std::max({ 
+            F[i][j] = std::max({
                 F[i - 1][j - 1] + match,  // Match/mismatch case
                 F[i - 1][j] - 1,          // Gap in S2
                 F[i][j - 1] - 1           // Gap in S1
@@ -40,20 +98,869 @@ int global_alignment(const std::string& S1, const std::string& S2) {
     return F[m][n];
 }
 
-int main() {
+// Fills row with the last row of the table for a[0..m) against b[0..n) (row[j] is the score of
+// all of a against b[0..j)). Reverse aligns the reversed strings instead, so row[j] becomes the
+// score of a against the last j characters of b. Only this one row is kept; diag carries the
+// cell up and to the left that the row has already overwritten.
+template <bool Reverse>
+void lastRow(const char* a, int m, const char* b, int n, std::vector<int>& row) {
+    row.resize(n + 1);
+    for (int j = 0; j <= n; ++j) row[j] = j * GAP;
+    for (int i = 1; i <= m; ++i) {
+        char ca = Reverse ? a[m - i] : a[i - 1];
+        int diag = row[0];
+        row[0] = i * GAP;
+        int left = row[0];
+        for (int j = 1; j <= n; ++j) {
+            char cb = Reverse ? b[n - j] : b[j - 1];
+            int up = row[j];
+            int best = diag + (ca == cb ? MATCH : MISMATCH);
+            best = std::max(best, up + GAP);
+            best = std::max(best, left + GAP);
+            row[j] = best;
+            diag = up;
+            left = best;
+        }
+    }
+}
+
+// Scoring policies. The row engine below is a template over what kind of alignment it is, how
+// two characters score and how gaps score, so each combination compiles into its own loop and the
+// default one (fixed match/mismatch, linear gaps) carries none of the others' work.
+
+// Global aligns both sequences end to end, Local (Smith-Waterman) the best pair of substrings,
+// and SemiGlobal both end to end but without charging gaps before or after either sequence
+enum class AlignMode { Global, Local, SemiGlobal };
+
+// The fixed +1 / -1 scheme
+struct SimpleScore {
+    int operator()(char a, char b) const { return a == b ? MATCH : MISMATCH; }
+};
+
+// A BLOSUM/PAM style table loaded from a file. The file has a header line of column characters
+// and then one line per row character followed by its scores; lines starting with '#' are
+// comments. Letters match in either case. Characters missing from the table score like '*'
+// when the table has that row, and otherwise as the table's lowest score.
+class SubstitutionMatrix {
+public:
+    SubstitutionMatrix() : table(256 * 256, 0), magnitude(0) {}
+
+    // Reads the table from path, false (with a message on stderr) when it cannot be used
+    bool load(const char* path) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            std::fprintf(stderr, "cannot open %s\n", path);
+            return false;
+        }
+        FastInput file(fd, 1 << 16);
+        std::string line, symbol;
+        std::vector<char> columns;
+        std::vector<char> rows;
+        std::vector<std::vector<int>> scores;
+        while (file.readLine(line)) {
+            std::istringstream fields(line);
+            if (!(fields >> symbol) || symbol[0] == '#') continue;
+            if (columns.empty()) {
+                do {
+                    columns.push_back(symbol[0]);
+                } while (fields >> symbol);
+                continue;
+            }
+            rows.push_back(symbol[0]);
+            scores.emplace_back();
+            long value;
+            while (fields >> value) {
+                if (value < -SCORE_LIMIT || value > SCORE_LIMIT) {
+                    std::fprintf(stderr, "%s: score %ld is past +-%d\n", path, value, SCORE_LIMIT);
+                    ::close(fd);
+                    return false;
+                }
+                scores.back().push_back(static_cast<int>(value));
+            }
+            if (scores.back().size() != columns.size()) {
+                std::fprintf(stderr, "%s: row %c has %zu scores for %zu columns\n", path, symbol[0],
+                             scores.back().size(), columns.size());
+                ::close(fd);
+                return false;
+            }
+        }
+        ::close(fd);
+        if (rows.empty()) {
+            std::fprintf(stderr, "%s: no scores\n", path);
+            return false;
+        }
+
+        // Table position of every character, -1 for the ones scored as the lowest entry
+        int lowest = INT_MAX;
+        for (const auto& row : scores) {
+            for (int value : row) {
+                lowest = std::min(lowest, value);
+                magnitude = std::max(magnitude, std::abs(value));
+            }
+        }
+        std::vector<int> row_of(256, -1), column_of(256, -1);
+        auto place = [](std::vector<int>& index, const std::vector<char>& symbols) {
+            for (size_t k = 0; k < symbols.size(); ++k) {
+                unsigned char c = symbols[k];
+                index[c] = k;
+                index[std::tolower(c)] = k;
+                index[std::toupper(c)] = k;
+            }
+            for (int c = 0; c < 256; ++c) {
+                if (index[c] < 0 && index['*'] >= 0) index[c] = index['*'];
+            }
+        };
+        place(row_of, rows);
+        place(column_of, columns);
+        for (int a = 0; a < 256; ++a) {
+            for (int b = 0; b < 256; ++b) {
+                table[a * 256 + b] = (row_of[a] < 0 || column_of[b] < 0) ? lowest : scores[row_of[a]][column_of[b]];
+            }
+        }
+        return true;
+    }
+
+    int operator()(char a, char b) const {
+        return table[static_cast<unsigned char>(a) * 256 + static_cast<unsigned char>(b)];
+    }
+
+    // Largest absolute score in the table
+    int largest() const { return magnitude; }
+
+private:
+    std::vector<int> table;  // 256 by 256, indexed by the raw bytes
+    int magnitude;
+};
+
+// A gap of length L scores L * extend
+struct LinearGap {
+    int extend;
+};
+
+// A gap of length L scores open + L * extend (Gotoh)
+struct AffineGap {
+    int open;
+    int extend;
+};
+
+// Scores a[0..m) against b[0..n) one row of the table at a time. row holds the best score H of
+// each column; with affine gaps vertical holds F, the best score of a cell ending in a gap that
+// consumes a, while E (ending in a gap that consumes b) only needs the cell to the left and is
+// carried in a register. With linear gaps both collapse into H and vertical is never touched.
+// Cell is int unless the scores of the pair could come near its NEG_INF (see cellsFitInt).
+template <AlignMode Mode, typename Cell, typename Substitution, typename Gap>
+Cell policyScore(const char* a, int m, const char* b, int n, const Substitution& score, const Gap& gap,
+                 std::vector<Cell>& row, std::vector<Cell>& vertical) {
+    constexpr bool affine = std::is_same<Gap, AffineGap>::value;
+    constexpr bool global = Mode == AlignMode::Global;
+    constexpr Cell neg_inf = std::numeric_limits<Cell>::min() / 4;
+    Cell open = 0;
+    if constexpr (affine) open = gap.open;
+    const Cell extend = gap.extend;
+
+    // Border cells: a leading gap of length k in global mode, free otherwise
+    auto border = [&](int k) { return (global && k > 0) ? open + k * extend : Cell(0); };
+
+    row.resize(n + 1);
+    for (int j = 0; j <= n; ++j) row[j] = border(j);
+    if constexpr (affine) vertical.assign(n + 1, neg_inf);
+    Cell best = 0;  // Local: the best cell so far; SemiGlobal: the best cell of the last column
+    if constexpr (Mode == AlignMode::SemiGlobal) best = row[n];
+
+    for (int i = 1; i <= m; ++i) {
+        const char ca = a[i - 1];
+        Cell diag = row[0];
+        row[0] = border(i);
+        Cell left = row[0];
+        Cell horizontal = neg_inf;  // E of the cell to the left
+        for (int j = 1; j <= n; ++j) {
+            Cell up = row[j];
+            Cell cell = diag + score(ca, b[j - 1]);
+            if constexpr (affine) {
+                horizontal = std::max(horizontal, left + open) + extend;
+                vertical[j] = std::max(vertical[j], up + open) + extend;
+                cell = std::max(cell, std::max(horizontal, vertical[j]));
+            } else {
+                cell = std::max(cell, std::max(up, left) + extend);
+            }
+            if constexpr (Mode == AlignMode::Local) {
+                cell = std::max(cell, Cell(0));
+                best = std::max(best, cell);
+            }
+            row[j] = cell;
+            diag = up;
+            left = cell;
+        }
+        if constexpr (Mode == AlignMode::SemiGlobal) best = std::max(best, row[n]);
+    }
+
+    if constexpr (Mode == AlignMode::Global) return row[n];
+    if constexpr (Mode == AlignMode::SemiGlobal) return std::max(best, *std::max_element(row.begin(), row.end()));
+    return best;
+}
+
+// Global alignment score in one row as long as the shorter sequence. Swapping the sequences
+// mirrors the table without changing the score. This is the engine's default instantiation.
+int alignmentScore(const std::string& S1, const std::string& S2, std::vector<int>& row) {
+    const std::string& rows = (S1.size() >= S2.size()) ? S1 : S2;
+    const std::string& cols = (S1.size() >= S2.size()) ? S2 : S1;
+    return policyScore<AlignMode::Global, int>(rows.data(), rows.size(), cols.data(), cols.size(), SimpleScore(),
+                                               LinearGap{GAP}, row, row);
+}
+
+// The vector kernels below walk the table by anti-diagonals instead of rows. Every cell on
+// diagonal d = i + j only needs diagonals d - 1 (up and left) and d - 2 (up-left), so a whole
+// diagonal can be filled in parallel lanes. Diagonals are stored by row i, and b is stored
+// reversed so the character of each cell is also contiguous in i. For one stretch of a diagonal
+// the kernels compute
+//     cur[t] = max(diag[t] + score(qa[t], rb[t]), max(up[t], left[t]) + GAP)
+// with every pointer already moved to the first cell of the stretch.
+
+// Scalar version of the stretch, also used for the tails of the vector ones
+template <typename Cell>
+void diagonalSpanScalar(Cell* cur, const Cell* diag, const Cell* up, const Cell* left, const Cell* qa,
+                        const Cell* rb, int count) {
+    for (int t = 0; t < count; ++t) {
+        int best = diag[t] + (qa[t] == rb[t] ? MATCH : MISMATCH);
+        best = std::max(best, std::max<int>(up[t], left[t]) + GAP);
+        cur[t] = static_cast<Cell>(best);
+    }
+}
+
+#if defined(__SSE2__)
+// Eight 16-bit cells per step, with saturating adds
+void diagonalSpan16SSE2(int16_t* cur, const int16_t* diag, const int16_t* up, const int16_t* left,
+                        const int16_t* qa, const int16_t* rb, int count) {
+    const __m128i mismatch = _mm_set1_epi16(MISMATCH);
+    const __m128i delta = _mm_set1_epi16(MATCH - MISMATCH);
+    const __m128i gap = _mm_set1_epi16(GAP);
+    int t = 0;
+    for (; t + 8 <= count; t += 8) {
+        __m128i same = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(qa + t)),
+                                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(rb + t)));
+        __m128i score = _mm_add_epi16(mismatch, _mm_and_si128(same, delta));
+        __m128i best = _mm_adds_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(diag + t)), score);
+        __m128i gapped = _mm_max_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(up + t)),
+                                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + t)));
+        best = _mm_max_epi16(best, _mm_adds_epi16(gapped, gap));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(cur + t), best);
+    }
+    diagonalSpanScalar(cur + t, diag + t, up + t, left + t, qa + t, rb + t, count - t);
+}
+
+// a > b ? a : b on every 32-bit lane, SSE2 only has the 16-bit max
+inline __m128i max32SSE2(__m128i a, __m128i b) {
+    __m128i greater = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+}
+
+// Four 32-bit cells per step
+void diagonalSpan32SSE2(int32_t* cur, const int32_t* diag, const int32_t* up, const int32_t* left,
+                        const int32_t* qa, const int32_t* rb, int count) {
+    const __m128i mismatch = _mm_set1_epi32(MISMATCH);
+    const __m128i delta = _mm_set1_epi32(MATCH - MISMATCH);
+    const __m128i gap = _mm_set1_epi32(GAP);
+    int t = 0;
+    for (; t + 4 <= count; t += 4) {
+        __m128i same = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(qa + t)),
+                                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(rb + t)));
+        __m128i score = _mm_add_epi32(mismatch, _mm_and_si128(same, delta));
+        __m128i best = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(diag + t)), score);
+        __m128i gapped = max32SSE2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(up + t)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + t)));
+        best = max32SSE2(best, _mm_add_epi32(gapped, gap));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(cur + t), best);
+    }
+    diagonalSpanScalar(cur + t, diag + t, up + t, left + t, qa + t, rb + t, count - t);
+}
+#endif
+
+#if defined(ALIGN_HAVE_AVX2)
+// diagonalSpan16SSE2 with sixteen cells per step
+__attribute__((target("avx2")))
+void diagonalSpan16AVX2(int16_t* cur, const int16_t* diag, const int16_t* up, const int16_t* left,
+                        const int16_t* qa, const int16_t* rb, int count) {
+    const __m256i mismatch = _mm256_set1_epi16(MISMATCH);
+    const __m256i delta = _mm256_set1_epi16(MATCH - MISMATCH);
+    const __m256i gap = _mm256_set1_epi16(GAP);
+    int t = 0;
+    for (; t + 16 <= count; t += 16) {
+        __m256i same = _mm256_cmpeq_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(qa + t)),
+                                          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rb + t)));
+        __m256i score = _mm256_add_epi16(mismatch, _mm256_and_si256(same, delta));
+        __m256i best = _mm256_adds_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(diag + t)), score);
+        __m256i gapped = _mm256_max_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(up + t)),
+                                          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + t)));
+        best = _mm256_max_epi16(best, _mm256_adds_epi16(gapped, gap));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(cur + t), best);
+    }
+    diagonalSpanScalar(cur + t, diag + t, up + t, left + t, qa + t, rb + t, count - t);
+}
+
+// diagonalSpan32SSE2 with eight cells per step and a real max
+__attribute__((target("avx2")))
+void diagonalSpan32AVX2(int32_t* cur, const int32_t* diag, const int32_t* up, const int32_t* left,
+                        const int32_t* qa, const int32_t* rb, int count) {
+    const __m256i mismatch = _mm256_set1_epi32(MISMATCH);
+    const __m256i delta = _mm256_set1_epi32(MATCH - MISMATCH);
+    const __m256i gap = _mm256_set1_epi32(GAP);
+    int t = 0;
+    for (; t + 8 <= count; t += 8) {
+        __m256i same = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(qa + t)),
+                                          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rb + t)));
+        __m256i score = _mm256_add_epi32(mismatch, _mm256_and_si256(same, delta));
+        __m256i best = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(diag + t)), score);
+        __m256i gapped = _mm256_max_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(up + t)),
+                                          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + t)));
+        best = _mm256_max_epi32(best, _mm256_add_epi32(gapped, gap));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(cur + t), best);
+    }
+    diagonalSpanScalar(cur + t, diag + t, up + t, left + t, qa + t, rb + t, count - t);
+}
+#endif
+
+// Buffers of one wavefront fill, kept between pairs so a batch stops allocating once they have
+// grown to its longest sequences
+template <typename Cell>
+struct WavefrontBuffers {
+    std::vector<Cell> qa, rb, diagonals;
+};
+
+// Anti-diagonal fill of the whole table with one of the stretch kernels. Three diagonals as long
+// as the shorter sequence are kept and rotated; the boundary cells (i = 0 or j = 0) are set
+// directly and everything between them goes through span.
+template <typename Cell>
+int wavefrontScore(const std::string& S1, const std::string& S2,
+                   void (*span)(Cell*, const Cell*, const Cell*, const Cell*, const Cell*, const Cell*, int),
+                   WavefrontBuffers<Cell>& buffers) {
+    const std::string& a = (S1.size() <= S2.size()) ? S1 : S2;
+    const std::string& b = (S1.size() <= S2.size()) ? S2 : S1;
+    const int m = a.size();
+    const int n = b.size();
+    if (m == 0) return n * GAP;
+
+    std::vector<Cell>& qa = buffers.qa;
+    std::vector<Cell>& rb = buffers.rb;
+    if (qa.size() < static_cast<size_t>(m + 1)) qa.resize(m + 1);
+    if (rb.size() < static_cast<size_t>(n)) rb.resize(n);
+    for (int i = 1; i <= m; ++i) qa[i] = static_cast<unsigned char>(a[i - 1]);
+    for (int k = 0; k < n; ++k) rb[k] = static_cast<unsigned char>(b[n - 1 - k]);  // b[j - 1] is rb[n - j]
+
+    // Every cell read below was written earlier in this fill, so stale contents do not matter
+    if (buffers.diagonals.size() < 3 * static_cast<size_t>(m + 1)) buffers.diagonals.resize(3 * static_cast<size_t>(m + 1));
+    Cell* diag = buffers.diagonals.data();  // Diagonal d - 2
+    Cell* prev = diag + (m + 1);    // Diagonal d - 1
+    Cell* cur = prev + (m + 1);     // Diagonal d
+    prev[0] = static_cast<Cell>(0);
+    for (int d = 1; d <= m + n; ++d) {
+        if (d <= n) cur[0] = static_cast<Cell>(d * GAP);
+        if (d <= m) cur[d] = static_cast<Cell>(d * GAP);
+        int lo = std::max(1, d - n);
+        int hi = std::min(m, d - 1);
+        if (lo <= hi) {
+            span(cur + lo, diag + lo - 1, prev + lo - 1, prev + lo, qa.data() + lo, rb.data() + (n - d + lo), hi - lo + 1);
+        }
+        Cell* spare = diag;
+        diag = prev;
+        prev = cur;
+        cur = spare;
+    }
+    return prev[m];
+}
+
+// How pairs are scored, filled in from the flags
+struct ScoringOptions {
+    AlignMode mode = AlignMode::Global;
+    const SubstitutionMatrix* matrix = nullptr;  // Fixed match/mismatch when null
+    bool affine = false;
+    int gap_open = 0;
+    int gap_extend = GAP;
+    bool scalar = false;
+    int band = -1;  // Negative means the whole table
+
+    // The fixed global scheme the vector, banded and traceback kernels are written for
+    bool simple() const { return mode == AlignMode::Global && matrix == nullptr && !affine && gap_extend == GAP; }
+
+    // Largest change of the score in one step of a path; a gap step may also pay the opening
+    long long largestStep() const {
+        long long substitution = matrix ? matrix->largest() : std::max(std::abs(MATCH), std::abs(MISMATCH));
+        return std::max(substitution, static_cast<long long>(std::abs(gap_open)) + std::abs(gap_extend));
+    }
+
+    // Whether the row engine can use int cells for an m by n table: every cell is within
+    // (m + n) * largestStep() of zero and has to stay far from NEG_INF, which gets one more
+    // step added to it before being compared away
+    bool cellsFitInt(size_t m, size_t n) const {
+        return static_cast<long long>(m + n + 1) * largestStep() <= -(NEG_INF / 2);
+    }
+};
+
+// Everything one thread needs to score pairs without allocating
+struct AlignScratch {
+    WavefrontBuffers<int16_t> narrow;
+    WavefrontBuffers<int32_t> wide;
+    std::vector<int> row;
+    std::vector<int> vertical;  // Affine gaps only
+    std::vector<long long> wide_row, wide_vertical;  // Row engine pairs too large for int cells
+};
+
+// Alignment score through the widest vector kernel the CPU has, for the default scoring. Every
+// cell on diagonal d is within d * largestStep() of zero, so 16-bit lanes are exact whenever
+// m + n steps fit in them and 32-bit lanes take over past that; without SSE2 it is the row kernel.
+int vectorScore(const std::string& S1, const std::string& S2, const ScoringOptions& options,
+                AlignScratch& scratch) {
+    const bool fits16 = static_cast<long long>(S1.size() + S2.size()) * options.largestStep() <= INT16_MAX;
+#if defined(ALIGN_HAVE_AVX2)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+        return fits16 ? wavefrontScore<int16_t>(S1, S2, diagonalSpan16AVX2, scratch.narrow)
+                      : wavefrontScore<int32_t>(S1, S2, diagonalSpan32AVX2, scratch.wide);
+    }
+#endif
+#if defined(__SSE2__)
+    return fits16 ? wavefrontScore<int16_t>(S1, S2, diagonalSpan16SSE2, scratch.narrow)
+                  : wavefrontScore<int32_t>(S1, S2, diagonalSpan32SSE2, scratch.wide);
+#else
+    return alignmentScore(S1, S2, scratch.row);
+#endif
+}
+
+// Diagonals j - i that a band of the given width keeps for an m by n table. Both ends of the
+// table have to be inside, so the band is widened by the length difference. Widths past the
+// longer sequence already keep every diagonal and are cut down to it.
+void bandDiagonals(int m, int n, int width, int& low, int& high) {
+    width = std::min(width, std::max(m, n));
+    low = std::min(0, n - m) - width;
+    high = std::max(0, n - m) + width;
+}
+
+// Global alignment score using only the cells whose diagonal j - i lies in [low, high], still
+// in one row. Cells just outside the band read as NEG_INF.
+int bandedScore(const std::string& S1, const std::string& S2, int width, std::vector<int>& row) {
+    const std::string& a = (S1.size() >= S2.size()) ? S1 : S2;
+    const std::string& b = (S1.size() >= S2.size()) ? S2 : S1;
+    const int m = a.size();
+    const int n = b.size();
+    int low, high;
+    bandDiagonals(m, n, width, low, high);
+
+    row.assign(n + 1, NEG_INF);
+    for (int j = 0; j <= std::min(n, high); ++j) row[j] = j * GAP;
+    for (int i = 1; i <= m; ++i) {
+        int lo = std::max(0, i + low);
+        int hi = std::min(n, i + high);
+        int diag, left, j;
+        if (lo == 0) {
+            diag = row[0];
+            row[0] = i * GAP;
+            left = row[0];
+            j = 1;
+        } else {
+            diag = row[lo - 1];
+            row[lo - 1] = NEG_INF;  // Left the band, the next row may read it as its diagonal
+            left = NEG_INF;
+            j = lo;
+        }
+        for (; j <= hi; ++j) {
+            int up = row[j];
+            int best = diag + (a[i - 1] == b[j - 1] ? MATCH : MISMATCH);
+            best = std::max(best, up + GAP);
+            best = std::max(best, left + GAP);
+            row[j] = best;
+            diag = up;
+            left = best;
+        }
+    }
+    return row[n];
+}
+
+
+// Reads the value of a scoring flag, false (with a message on stderr) when it is not a number
+// within SCORE_LIMIT
+bool parseScore(const char* flag, const char* text, int& value) {
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < -SCORE_LIMIT || parsed > SCORE_LIMIT) {
+        std::fprintf(stderr, "%s needs a score within +-%d, got '%s'\n", flag, SCORE_LIMIT, text);
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// Reads the width given to --band, false (with a message on stderr) when it is not a count of
+// 0 or more
+bool parseBand(const char* text, int& width) {
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || parsed < 0 || parsed > INT_MAX) {
+        std::fprintf(stderr, "--band needs a width between 0 and %d, got '%s'\n", INT_MAX, text);
+        return false;
+    }
+    width = static_cast<int>(parsed);
+    return true;
+}
+
+// Picks the gap policy and cell width of the row engine
+template <AlignMode Mode, typename Substitution>
+long long scoreWithGaps(const std::string& S1, const std::string& S2, const Substitution& score,
+                        const ScoringOptions& options, AlignScratch& scratch) {
+    // Without a matrix the scoring is symmetric, so the row can run along the shorter sequence
+    const bool swap = options.matrix == nullptr && S2.size() > S1.size();
+    const std::string& a = swap ? S2 : S1;
+    const std::string& b = swap ? S1 : S2;
+    const AffineGap affine{options.gap_open, options.gap_extend};
+    const LinearGap linear{options.gap_extend};
+    if (options.cellsFitInt(a.size(), b.size())) {
+        return options.affine
+                   ? policyScore<Mode, int>(a.data(), a.size(), b.data(), b.size(), score, affine, scratch.row, scratch.vertical)
+                   : policyScore<Mode, int>(a.data(), a.size(), b.data(), b.size(), score, linear, scratch.row, scratch.vertical);
+    }
+    return options.affine ? policyScore<Mode, long long>(a.data(), a.size(), b.data(), b.size(), score, affine,
+                                                         scratch.wide_row, scratch.wide_vertical)
+                          : policyScore<Mode, long long>(a.data(), a.size(), b.data(), b.size(), score, linear,
+                                                         scratch.wide_row, scratch.wide_vertical);
+}
+
+// Picks the substitution policy of the row engine
+template <AlignMode Mode>
+long long scoreWithMode(const std::string& S1, const std::string& S2, const ScoringOptions& options, AlignScratch& scratch) {
+    if (options.matrix != nullptr) return scoreWithGaps<Mode>(S1, S2, *options.matrix, options, scratch);
+    return scoreWithGaps<Mode>(S1, S2, SimpleScore(), options, scratch);
+}
+
+// Score of one pair the way the flags ask for. The fixed global scheme is banded when band is
+// not negative and otherwise goes to the vector kernel or, with scalar, the row kernel; every
+// other scheme goes to the row engine instantiated for it.
+long long scorePair(const std::string& S1, const std::string& S2, const ScoringOptions& options, AlignScratch& scratch) {
+    if (options.simple()) {
+        if (options.band >= 0) return bandedScore(S1, S2, options.band, scratch.row);
+        return options.scalar ? alignmentScore(S1, S2, scratch.row) : vectorScore(S1, S2, options, scratch);
+    }
+    switch (options.mode) {
+        case AlignMode::Local:
+            return scoreWithMode<AlignMode::Local>(S1, S2, options, scratch);
+        case AlignMode::SemiGlobal:
+            return scoreWithMode<AlignMode::SemiGlobal>(S1, S2, options, scratch);
+        default:
+            return scoreWithMode<AlignMode::Global>(S1, S2, options, scratch);
+    }
+}
+
+// Traceback moves, preferred in this order when several are optimal
+enum Move : unsigned char { DIAGONAL, UP, LEFT };
+
+// Aligns a[0..m) with b[0..n) by filling the cells on diagonals [low, high] with their best move
+// and tracing back from the corner, appending the aligned rows to out1 and out2. With the full
+// band this is the plain quadratic traceback Hirschberg bottoms out in; with a narrow one it needs
+// only (high - low + 1) bytes per row.
+void alignBand(const char* a, int m, const char* b, int n, int low, int high,
+               std::string& out1, std::string& out2) {
+    const int width = high - low + 1;
+    std::vector<unsigned char> moves(static_cast<size_t>(m + 1) * width);
+    std::vector<int> row(n + 1, NEG_INF);
+    for (int j = 0; j <= std::min(n, high); ++j) {
+        row[j] = j * GAP;
+        moves[j - low] = LEFT;
+    }
+    for (int i = 1; i <= m; ++i) {
+        unsigned char* move = moves.data() + static_cast<size_t>(i) * width - (i + low);  // Indexed by j
+        int lo = std::max(0, i + low);
+        int hi = std::min(n, i + high);
+        int diag, left, j;
+        if (lo == 0) {
+            diag = row[0];
+            row[0] = i * GAP;
+            move[0] = UP;
+            left = row[0];
+            j = 1;
+        } else {
+            diag = row[lo - 1];
+            row[lo - 1] = NEG_INF;
+            left = NEG_INF;
+            j = lo;
+        }
+        for (; j <= hi; ++j) {
+            int up = row[j];
+            int best = diag + (a[i - 1] == b[j - 1] ? MATCH : MISMATCH);
+            unsigned char how = DIAGONAL;
+            if (up + GAP > best) {
+                best = up + GAP;
+                how = UP;
+            }
+            if (left + GAP > best) {
+                best = left + GAP;
+                how = LEFT;
+            }
+            row[j] = best;
+            move[j] = how;
+            diag = up;
+            left = best;
+        }
+    }
+
+    // Walk back from the corner, collecting the columns in reverse
+    std::string back1, back2;
+    int i = m, j = n;
+    while (i > 0 || j > 0) {
+        unsigned char how = moves[static_cast<size_t>(i) * width + (j - i - low)];
+        if (how == DIAGONAL) {
+            back1 += a[--i];
+            back2 += b[--j];
+        } else if (how == UP) {
+            back1 += a[--i];
+            back2 += '-';
+        } else {
+            back1 += '-';
+            back2 += b[--j];
+        }
+    }
+    out1.append(back1.rbegin(), back1.rend());
+    out2.append(back2.rbegin(), back2.rend());
+}
+
+// Hirschberg's alignment: the forward scores of the top half of a and the reverse scores of the
+// bottom half meet in the column where an optimal path crosses the middle row, and the two
+// quadrants around that point are aligned recursively. Memory stays linear because only the two
+// score rows are alive at a time; the time is about twice the score-only fill.
+void hirschberg(const char* a, int m, const char* b, int n, std::vector<int>& forward,
+                std::vector<int>& backward, std::string& out1, std::string& out2) {
+    if (m <= 1 || n == 0 || static_cast<long long>(m + 1) * (n + 1) <= HIRSCHBERG_BASE_CELLS) {
+        alignBand(a, m, b, n, -m, n, out1, out2);
+        return;
+    }
+    int mid = m / 2;
+    lastRow<false>(a, mid, b, n, forward);
+    lastRow<true>(a + mid, m - mid, b, n, backward);
+    int split = 0;
+    int best = INT_MIN;
+    for (int j = 0; j <= n; ++j) {
+        int total = forward[j] + backward[n - j];
+        if (total > best) {
+            best = total;
+            split = j;
+        }
+    }
+    hirschberg(a, mid, b, split, forward, backward, out1, out2);
+    hirschberg(a + mid, m - mid, b + split, n - split, forward, backward, out1, out2);
+}
+
+// Score of an alignment printed by --align, summed column by column
+int scoreColumns(const std::string& out1, const std::string& out2) {
+    int score = 0;
+    for (size_t c = 0; c < out1.size(); ++c) {
+        if (out1[c] == '-' || out2[c] == '-') {
+            score += GAP;
+        } else {
+            score += (out1[c] == out2[c]) ? MATCH : MISMATCH;
+        }
+    }
+    return score;
+}
+
+// Pairs a worker claims at a time. Two 150 base reads take about 12 us to score, already a
+// hundred fetch_adds, so the grain only has to cover pairs of a few dozen bases; at 16 a full
+// chunk still splits into a thousand grains, which keeps pairs of uneven length balanced.
+const size_t PAIR_GRAIN = 16;
+
+// A batch chunk is scored once it holds this many pairs or this many sequence bytes
+const size_t CHUNK_PAIRS = 1 << 14;
+const size_t CHUNK_BYTES = 1 << 26;
+
+// Reads the sequences of a batch one record at a time. A line starting with '>' opens a FASTA
+// record whose sequence is every following line up to the next header; any other line outside
+// a record is a sequence on its own.
+class RecordReader {
+public:
+    explicit RecordReader(FastInput& in) : in(in), pending(false) {}
+
+    // Reads the next sequence into seq (reusing its storage), false at end of input
+    bool next(std::string& seq) {
+        if (!pending && !in.readLine(line)) return false;
+        pending = false;
+        if (line.empty() || line[0] != '>') {
+            seq.swap(line);
+            return true;
+        }
+        seq.clear();
+        while (in.readLine(line)) {
+            if (!line.empty() && line[0] == '>') {
+                pending = true;  // Header of the next record
+                break;
+            }
+            seq += line;
+        }
+        return true;
+    }
+
+private:
+    FastInput& in;
+    std::string line;
+    bool pending;  // line already holds the next header
+};
+
+// Scores a stream of pairs and prints one score per line in input order. Records are taken two
+// at a time, or with oneVsMany the first record is the query and every later one a target.
+// The records are read a chunk at a time and each chunk is scored by threads claiming pairs
+// from a shared counter; every thread keeps its own scratch across chunks, so once the buffers
+// have grown to the longest sequences no pair allocates. With stats the cell updates per
+// second of the scoring (reading and printing excluded) go to stderr.
+void runBatch(bool oneVsMany, const ScoringOptions& options, unsigned threads, bool stats) {
+    RecordReader reader(input);
+    std::string query;
+    if (oneVsMany && !reader.next(query)) return;
+
+    const size_t per_pair = oneVsMany ? 1 : 2;
+    std::vector<std::string> records(CHUNK_PAIRS * per_pair);
+    std::vector<long long> scores(CHUNK_PAIRS);
+    std::vector<AlignScratch> scratch(threads);
+    size_t total_pairs = 0;
+    double total_cells = 0;
+    double seconds = 0;
+
+    while (true) {
+        size_t count = 0;
+        size_t bytes = 0;
+        // A chunk never stops between the two halves of a pair
+        while (count < records.size() && (bytes < CHUNK_BYTES || count % per_pair != 0) &&
+               reader.next(records[count])) {
+            bytes += records[count].size();
+            ++count;
+        }
+        size_t pairs = count / per_pair;
+        if (count % per_pair != 0) std::fprintf(stderr, "ignoring a last sequence without a partner\n");
+        if (pairs == 0) break;
+
+        auto started = std::chrono::steady_clock::now();
+        std::atomic<size_t> next_pair(0);
+        auto worker = [&](unsigned t) {
+            while (true) {
+                size_t first = next_pair.fetch_add(PAIR_GRAIN);
+                if (first >= pairs) break;
+                size_t last = std::min(first + PAIR_GRAIN, pairs);
+                for (size_t p = first; p < last; ++p) {
+                    const std::string& a = oneVsMany ? query : records[2 * p];
+                    const std::string& b = oneVsMany ? records[p] : records[2 * p + 1];
+                    scores[p] = scorePair(a, b, options, scratch[t]);
+                }
+            }
+        };
+        size_t helpers = std::min<size_t>(threads, (pairs + PAIR_GRAIN - 1) / PAIR_GRAIN);
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < helpers; ++t) pool.emplace_back(worker, static_cast<unsigned>(t));
+        worker(0);
+        for (auto& t : pool) t.join();
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+        for (size_t p = 0; p < pairs; ++p) {
+            const std::string& a = oneVsMany ? query : records[2 * p];
+            const std::string& b = oneVsMany ? records[p] : records[2 * p + 1];
+            total_cells += static_cast<double>(a.size()) * b.size();
+            output.writeInt(scores[p]);
+            output.writeChar('\n');
+        }
+        total_pairs += pairs;
+    }
+
+    if (stats) {
+        std::fprintf(stderr, "%zu pairs, %.3g cells in %.3f s on %u threads, %.2f GCUPS\n", total_pairs,
+                     total_cells, seconds, threads, seconds > 0 ? total_cells / seconds / 1e9 : 0.0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool reference = false;
+    bool align = false;
+    bool batch = false;
+    bool oneVsMany = false;
+    bool stats = false;
+    unsigned threads = 1;
+    ScoringOptions options;
+    SubstitutionMatrix matrix;
+    for (int a = 1; a < argc; ++a) {
+        if (std::strcmp(argv[a], "--reference") == 0) {
+            reference = true;
+        } else if (std::strcmp(argv[a], "--align") == 0) {
+            align = true;
+        } else if (std::strcmp(argv[a], "--scalar") == 0) {
+            options.scalar = true;
+        } else if (std::strcmp(argv[a], "--band") == 0 && a + 1 < argc) {
+            if (!parseBand(argv[++a], options.band)) return 1;
+        } else if (std::strcmp(argv[a], "--local") == 0) {
+            options.mode = AlignMode::Local;
+        } else if (std::strcmp(argv[a], "--semi-global") == 0) {
+            options.mode = AlignMode::SemiGlobal;
+        } else if (std::strcmp(argv[a], "--matrix") == 0 && a + 1 < argc) {
+            if (!matrix.load(argv[++a])) return 1;
+            options.matrix = &matrix;
+        } else if (std::strcmp(argv[a], "--gap") == 0 && a + 1 < argc) {
+            if (!parseScore("--gap", argv[++a], options.gap_extend)) return 1;
+        } else if (std::strcmp(argv[a], "--gap-open") == 0 && a + 1 < argc) {
+            options.affine = true;
+            if (!parseScore("--gap-open", argv[++a], options.gap_open)) return 1;
+        } else if (std::strcmp(argv[a], "--batch") == 0) {
+            batch = true;
+        } else if (std::strcmp(argv[a], "--one-vs-many") == 0) {
+            batch = true;
+            oneVsMany = true;
+        } else if (std::strcmp(argv[a], "--stats") == 0) {
+            stats = true;
+        } else if (std::strcmp(argv[a], "--threads") == 0 && a + 1 < argc) {
+            if (!parseThreadCount(argv[++a], threads)) return 1;
+        }
+    }
+
+    if (!options.simple() && (align || options.band >= 0 || reference)) {
+        std::fprintf(stderr, "--align, --band and --reference only use the default scoring\n");
+        return 1;
+    }
+
+    if (batch) {
+        runBatch(oneVsMany, options, threads, stats);
+        return 0;
+    }
+
     std::string S1, S2;
 
-    // Read two sequences from standard input 
-    std::getline(std::cin, S1);  // First sequence
-    std::getline(std::cin, S2);  // Second sequence
+    // Read two sequences from standard input
+    input.readLine(S1);  // First sequence
+    input.readLine(S2);  // Second sequence
+
+    if (reference) {
+        std::cout << global_alignment(S1, S2) << std::endl;
+        return 0;
+    }
+
+    if (align) {
+        const int m = S1.size();
+        const int n = S2.size();
+        std::string out1, out2;
+        if (options.band >= 0) {
+            int low, high;
+            bandDiagonals(m, n, options.band, low, high);
+            alignBand(S1.data(), m, S2.data(), n, low, high, out1, out2);
+        } else {
+            std::vector<int> forward, backward;
+            hirschberg(S1.data(), m, S2.data(), n, forward, backward, out1, out2);
+        }
+        output.writeInt(scoreColumns(out1, out2));
+        output.writeChar('\n');
+        output.writeString(out1);
+        output.writeChar('\n');
+        output.writeString(out2);
+        output.writeChar('\n');
+        return 0;
+    }
 
     // Compute the optimal alignment score
-    int score = global_alignment(S1, S2);
+    AlignScratch scratch;
+    long long score = scorePair(S1, S2, options, scratch);
 
     // Output the result as a number (without any text)
-    std::cout << score << std::endl;
+    output.writeInt(score);
+    output.writeChar('\n');
 
     return 0;
 }
-
-
@@ -0,0 +1,236 @@
+//Jonathan Attanasio
+//
+//Description: Small buffered I/O layer shared by the challenge programs. Reading stdin through
+//std::cin and flushing with std::endl on every line cost more than the algorithms themselves
+//on large inputs, so this reads stdin in large blocks, parses integers by hand and collects all
+//output in one buffer that is written out in big chunks.
+
+#ifndef FASTIO_H
+#define FASTIO_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <unistd.h>
+
+// Reads a file descriptor (stdin by default) through one large reusable buffer
+class FastInput {
+public:
+    explicit FastInput(int fd = 0, size_t capacity = 1 << 20)
+        : fd(fd), buffer(capacity), pos(0), len(0), eof(false) {}
+
+    // Reads the next whitespace separated integer, false at end of input, when the next token
+    // is not a number or when it does not fit in T (like std::cin >> n failing)
+    template <typename T>
+    bool readInt(T& value) {
+        static_assert(std::is_integral<T>::value, "readInt needs an integer type");
+        typedef typename std::make_unsigned<T>::type Unsigned;
+        skipSpace();
+        int c = peek();
+        bool negative = false;
+        if (c == '-' || c == '+') {
+            negative = (c == '-');
+            ++pos;
+            c = peek();
+        }
+        if (c < '0' || c > '9') return false;
+
+        // A negative signed value may reach one past the largest positive one
+        const Unsigned limit = static_cast<Unsigned>(std::numeric_limits<T>::max()) +
+                               ((std::is_signed<T>::value && negative) ? 1 : 0);
+        Unsigned result = 0;
+        while (c >= '0' && c <= '9') {
+            Unsigned digit = static_cast<Unsigned>(c - '0');
+            if (result > (limit - digit) / 10) return false;
+            result = result * 10 + digit;
+            ++pos;
+            c = peek();
+        }
+        value = negative ? static_cast<T>(0 - result) : static_cast<T>(result);
+        return true;
+    }
+
+    // Reads the next non-whitespace character
+    bool readChar(char& value) {
+        skipSpace();
+        int c = peek();
+        if (c < 0) return false;
+        value = static_cast<char>(c);
+        ++pos;
+        return true;
+    }
+
+    // Reads the next whitespace separated token
+    bool readToken(std::string& token) {
+        skipSpace();
+        token.clear();
+        while (true) {
+            if (pos == len && !refill()) break;
+            size_t start = pos;
+            while (pos < len && !isSpace(buffer[pos])) ++pos;
+            token.append(buffer.data() + start, pos - start);
+            if (pos < len) break;
+        }
+        return !token.empty();
+    }
+
+    // Reads up to the next '\n' (which is dropped), false only at end of input
+    bool readLine(std::string& line) {
+        line.clear();
+        if (peek() < 0) return false;
+        while (true) {
+            if (pos == len && !refill()) break;
+            const char* start = buffer.data() + pos;
+            const char* newline = static_cast<const char*>(std::memchr(start, '\n', len - pos));
+            if (newline != nullptr) {
+                line.append(start, newline - start);
+                pos += (newline - start) + 1;
+                break;
+            }
+            line.append(start, len - pos);
+            pos = len;
+        }
+        return true;
+    }
+
+    // Reads up to size raw bytes, handing out whatever is still buffered first and otherwise
+    // reading straight into dst. Returns 0 only at end of input.
+    size_t readRaw(char* dst, size_t size) {
+        if (pos < len) {
+            size_t count = std::min(size, len - pos);
+            std::memcpy(dst, buffer.data() + pos, count);
+            pos += count;
+            return count;
+        }
+        while (!eof && size > 0) {
+            ssize_t got = ::read(fd, dst, size);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) {
+                eof = true;
+                break;
+            }
+            return static_cast<size_t>(got);
+        }
+        return 0;
+    }
+
+    // Whitespace that separates tokens, also used by callers that scan readRaw blocks
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+private:
+    // Next unread byte, or -1 once the input is exhausted
+    int peek() {
+        if (pos == len && !refill()) return -1;
+        return static_cast<unsigned char>(buffer[pos]);
+    }
+
+    void skipSpace() {
+        int c;
+        while ((c = peek()) >= 0 && isSpace(static_cast<char>(c))) ++pos;
+    }
+
+    bool refill() {
+        if (eof) return false;
+        pos = 0;
+        len = 0;
+        while (true) {
+            ssize_t got = ::read(fd, buffer.data(), buffer.size());
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) {
+                eof = true;
+                return false;
+            }
+            len = static_cast<size_t>(got);
+            return true;
+        }
+    }
+
+    int fd;
+    std::vector<char> buffer;
+    size_t pos;  // Next unread byte in buffer
+    size_t len;  // Valid bytes in buffer
+    bool eof;
+};
+
+// Collects output in one large buffer and writes it out when full or destroyed
+class FastOutput {
+public:
+    explicit FastOutput(int fd = 1, size_t capacity = 1 << 20)
+        : fd(fd), buffer(capacity), len(0) {}
+
+    ~FastOutput() { flush(); }
+
+    FastOutput(const FastOutput&) = delete;
+    FastOutput& operator=(const FastOutput&) = delete;
+
+    template <typename T>
+    void writeInt(T value) {
+        static_assert(std::is_integral<T>::value, "writeInt needs an integer type");
+        char digits[24];
+        int count = 0;
+        typename std::make_unsigned<T>::type magnitude = static_cast<typename std::make_unsigned<T>::type>(value);
+        if (value < 0) {
+            writeChar('-');
+            magnitude = 0 - magnitude;
+        }
+        do {
+            digits[count++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        reserve(count);
+        while (count > 0) buffer[len++] = digits[--count];
+    }
+
+    void writeChar(char c) {
+        reserve(1);
+        buffer[len++] = c;
+    }
+
+    void writeString(const char* data, size_t size) {
+        if (size >= buffer.size()) {
+            flush();
+            writeAll(data, size);
+            return;
+        }
+        reserve(size);
+        std::memcpy(buffer.data() + len, data, size);
+        len += size;
+    }
+
+    void writeString(const std::string& text) { writeString(text.data(), text.size()); }
+
+    void writeString(const char* text) { writeString(text, std::strlen(text)); }
+
+    void flush() {
+        writeAll(buffer.data(), len);
+        len = 0;
+    }
+
+private:
+    void reserve(size_t size) {
+        if (len + size > buffer.size()) flush();
+    }
+
+    void writeAll(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t put = ::write(fd, data, size);
+            if (put < 0 && errno == EINTR) continue;
+            if (put <= 0) return;  // Nowhere left to write, drop the rest like a closed stream
+            data += put;
+            size -= static_cast<size_t>(put);
+        }
+    }
+
+    int fd;
+    std::vector<char> buffer;
+    size_t len;  // Bytes waiting to be written
+};
+
+#endif
@@ -0,0 +1,63 @@
+//Jonathan Attanasio
+//
+//Description: Command line handling for --threads and the chunked thread pool shared by the
+//challenge programs that can spread their work over several threads. Every program sizes
+//per-thread scratch space from the count, so it is checked here once instead of trusting atoi.
+
+#ifndef THREADS_H
+#define THREADS_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// More threads than this many per core only add scheduling and scratch memory
+const unsigned THREADS_PER_CORE_LIMIT = 4;
+
+// Parses the value of --threads into threads. 0 picks one thread per core and counts above
+// THREADS_PER_CORE_LIMIT per core are capped. Negative or non-numeric values print a message
+// on stderr and return false.
+inline bool parseThreadCount(const char* text, unsigned& threads) {
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || value < 0) {
+        std::fprintf(stderr, "--threads needs a count of 0 or more, got '%s'\n", text);
+        return false;
+    }
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned limit = cores * THREADS_PER_CORE_LIMIT;
+    if (value == 0) {
+        threads = cores;
+    } else if (static_cast<unsigned long>(value) > limit) {
+        std::fprintf(stderr, "--threads %ld capped at %u\n", value, limit);
+        threads = limit;
+    } else {
+        threads = static_cast<unsigned>(value);
+    }
+    return true;
+}
+
+// Runs work(t, lo, hi) on slice t of [begin, end), one thread per slice. A single thread runs
+// the work on the caller instead of starting a new one.
+template <typename Work>
+void parallelChunks(unsigned threads, size_t begin, size_t end, Work work) {
+    if (threads <= 1) {
+        work(0, begin, end);
+        return;
+    }
+    std::vector<std::thread> pool;
+    size_t total = end - begin;
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t lo = begin + total * t / threads;
+        size_t hi = begin + total * (t + 1) / threads;
+        pool.emplace_back(work, t, lo, hi);
+    }
+    for (auto& worker : pool) worker.join();
+}
+
+#endif